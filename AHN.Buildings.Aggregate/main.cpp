@@ -8,6 +8,7 @@
 #include <ctime>
 #include <stdexcept>
 #include <cmath>
+#include <thread>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -18,7 +19,7 @@
 #include <CloudTools.Common/IO/Reporter.h>
 #include <CloudTools.DEM/Metadata.h>
 #include <CloudTools.DEM/Rasterize.h>
-#include <CloudTools.DEM/SweepLineCalculation.hpp>
+#include <CloudTools.DEM/SweepLineReduction.hpp>
 #include "Region.h"
 
 namespace po = boost::program_options;
@@ -47,6 +48,7 @@ int main(int argc, char* argv[]) try
 	bool webEnable = false;
 	float webTolerance = 5.f;
 	std::string webSRS = "EPSG:900913";
+	unsigned short maxJobs = std::thread::hardware_concurrency();
 
 	// Read console arguments
 	po::options_description desc("Allowed options");
@@ -63,6 +65,8 @@ int main(int argc, char* argv[]) try
 			"tolerance for web output polygon generalization")
 		("web-srs", po::value<std::string>(&webSRS)->default_value(webSRS),
 			"spatial reference system for web output (reprojection)")		
+		("jobs,j", po::value<unsigned short>(&maxJobs)->default_value(maxJobs),
+			"number of threads to aggregate a tile with")
 		("help,h", "produce help message")
 		;
 
@@ -143,6 +147,22 @@ int main(int argc, char* argv[]) try
 
 	// Calculating aggregated altimetry change data
 	std::map<int, Region> results;
+	auto mergeResults = [](std::map<int, Region>& results, const std::map<int, Region>& other)
+	{
+		for (const auto& region : other)
+		{
+			auto it = results.find(region.first);
+			if (it == results.end())
+				results.insert(region);
+			else
+			{
+				it->second.gained += region.second.gained;
+				it->second.lost += region.second.lost;
+				it->second.moved += region.second.moved;
+				it->second.difference += region.second.difference;
+			}
+		}
+	};
 	for (fs::directory_iterator ahnFile(ahnDir); ahnFile != fs::directory_iterator(); ++ahnFile)
 	{
 		if (fs::is_regular_file(ahnFile->status()) && ahnFile->path().extension() == ".tif")
@@ -186,8 +206,8 @@ int main(int argc, char* argv[]) try
 				reporter.report(.5f, std::string());
 
 			// Altimetry change aggregation
-			SweepLineCalculation<double> calculation({ ahnPath.string(), adminRasterPath.string() },
-				[&results](int x, int y, const std::vector<Window<double>>& data) // NOT float
+			SweepLineReduction<double, std::map<int, Region>> calculation({ ahnPath.string(), adminRasterPath.string() }, 0,
+				[](int x, int y, const std::vector<Window<double>>& data, std::map<int, Region>& results) // NOT float
 			{
 				const auto& ahn = data[0];
 				const auto& admin = data[1];
@@ -208,16 +228,20 @@ int main(int argc, char* argv[]) try
 					results[id].moved += std::abs(change);
 					results[id].difference += change;
 				}
-			}, 
+			},
+				mergeResults,
+				std::map<int, Region>(),
 				[&reporter](float complete, const std::string &message)
 			{
 				reporter.report(.5f + complete / 2, message);
 				return true;
 			});
 			calculation.spatialReference = "EPSG:28992";
+			calculation.threadCount = maxJobs;
 			
 			// Execute operation
 			calculation.execute();
+			mergeResults(results, calculation.result());
 		}
 	}
 
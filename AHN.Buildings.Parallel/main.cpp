@@ -24,6 +24,7 @@ namespace fs = boost::filesystem;
 
 using namespace CloudTools::IO;
 using namespace AHN::Buildings;
+using CloudTools::DEM::Quantization;
 
 /// <summary>
 /// Mutex for guarding the starting of a new tile process.
@@ -55,10 +56,13 @@ fs::path lookupFile(const std::string& directory, const std::string& tileName);
 /// <param name="ahn2Terrain">AHN-2 terrain DEM directory path.</param>
 /// <param name="ahn3Terrain">AHN-3 terrain DEM directory path.</param>
 /// <param name="outputDir">Result directory path.</param>
+/// <param name="colorFile">Map file for color relief.</param>
+/// <param name="quantization">Quantization of the intermediate height rasters.</param>
 void processTile(const std::string& tileName,
                  const std::string& ahn2Surface, const std::string& ahn3Surface,
                  const std::string& ahn2Terrain, const std::string& ahn3Terrain,
-                 const std::string& outputDir, const std::string& colorFile);
+                 const std::string& outputDir, const std::string& colorFile,
+                 const Quantization& quantization);
 
 int main(int argc, char* argv[]) try
 {
@@ -68,6 +72,7 @@ int main(int argc, char* argv[]) try
 	            ahn3TerrainDir;
 	std::string outputDir = fs::current_path().string();
 	std::string colorFile;
+	double quantizationScale = 0;
 	std::string pattern = "[[:digit:]]{2}[[:alpha:]]{2}[[:digit:]]";
 	unsigned short maxJobs = std::thread::hardware_concurrency();
 
@@ -89,6 +94,8 @@ int main(int argc, char* argv[]) try
 		("color-file", po::value<std::string>(&colorFile),
 		 "map file for color relief; see:\n"
 		 "http://www.gdal.org/gdaldem.html")
+		("quantize", po::value<double>(&quantizationScale),
+		 "store the intermediate height rasters as 16 bit integers with the given step (e.g. 0.01 for centimetres)")
 		("jobs,j", po::value<unsigned short>(&maxJobs)->default_value(maxJobs),
 		 "number of maximum jobs to execute simultaneously")
 		("help,h", "produce help message");
@@ -148,6 +155,12 @@ int main(int argc, char* argv[]) try
 		argumentError = true;
 	}
 
+	if (vm.count("quantize") && !(quantizationScale > 0))
+	{
+		std::cerr << "The quantization step must be positive." << std::endl;
+		argumentError = true;
+	}
+
 	if (argumentError)
 	{
 		std::cerr << "Use the --help option for description." << std::endl;
@@ -241,7 +254,8 @@ int main(int argc, char* argv[]) try
 					                          processTile, tileName,
 					                          ahn2SurfaceFile, ahn3SurfaceFile,
 					                          ahn2TerrainFile, ahn3TerrainFile,
-					                          outputDir, colorFile)));
+					                          outputDir, colorFile,
+					                          vm.count("quantize") ? Quantization(quantizationScale) : Quantization())));
 			}
 		}
 	}
@@ -304,7 +318,8 @@ fs::path lookupFile(const std::string& directory, const std::string& tileName)
 void processTile(const std::string& tileName,
                  const std::string& ahn2Surface, const std::string& ahn3Surface,
                  const std::string& ahn2Terrain, const std::string& ahn3Terrain,
-                 const std::string& outputDir, const std::string& colorFile)
+                 const std::string& outputDir, const std::string& colorFile,
+                 const Quantization& quantization)
 {
 	// Variable for the detection of the end of initialization
 	BarReporter reporter;
@@ -341,6 +356,7 @@ void processTile(const std::string& tileName,
 			return true;
 		};
 	process->colorFile = colorFile;
+	process->quantization = quantization;
 
 	// Execute process
 	try
@@ -1,10 +0,0 @@
-#pragma once
-
-#include <ogr_core.h>
-
-enum Coverage : GByte
-{
-	NoData = 0,
-	Accept = 1,
-	Reject = 2
-};
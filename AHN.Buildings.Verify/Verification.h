@@ -0,0 +1,36 @@
+#pragma once
+
+/// <summary>
+/// Represents the accumulated result of a verification.
+/// </summary>
+struct Verification
+{
+	/// <summary>
+	/// The number of approved changes.
+	/// </summary>
+	unsigned long approvedCount = 0;
+	/// <summary>
+	/// The number of rejected changes.
+	/// </summary>
+	unsigned long rejectedCount = 0;
+	/// <summary>
+	/// The cumulative absolute altimetry of approved changes.
+	/// </summary>
+	double approvedSum = 0;
+	/// <summary>
+	/// The cumulative absolute altimetry of rejected changes.
+	/// </summary>
+	double rejectedSum = 0;
+
+	/// <summary>
+	/// Merges another verification result into this one.
+	/// </summary>
+	Verification& operator+=(const Verification& other)
+	{
+		approvedCount += other.approvedCount;
+		rejectedCount += other.rejectedCount;
+		approvedSum += other.approvedSum;
+		rejectedSum += other.rejectedSum;
+		return *this;
+	}
+};
@@ -8,6 +8,7 @@
 #include <ctime>
 #include <stdexcept>
 #include <cmath>
+#include <thread>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -18,9 +19,11 @@
 #include <CloudTools.Common/IO/Reporter.h>
 #include <CloudTools.DEM/Metadata.h>
 #include <CloudTools.DEM/Rasterize.h>
+#include <CloudTools.DEM/BitMask.hpp>
 #include <CloudTools.DEM/SweepLineCalculation.hpp>
+#include <CloudTools.DEM/SweepLineReduction.hpp>
 #include <CloudTools.DEM/SweepLineTransformation.hpp>
-#include "Coverage.h"
+#include "Verification.h"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -41,6 +44,7 @@ int main(int argc, char* argv[]) try
 	std::vector<std::string> dirLayers;
 
 	unsigned int coverageExpansion = 2;
+	unsigned short maxJobs = std::thread::hardware_concurrency();
 
 	// Read console arguments
 	po::options_description desc("Allowed options");
@@ -61,6 +65,8 @@ int main(int argc, char* argv[]) try
 			"layer name for reference directories")
 		("coverage-expansion", po::value<unsigned int>(&coverageExpansion)->default_value(coverageExpansion),
 			"expansion of coverage in meters for overlay correction")
+		("jobs,j", po::value<unsigned short>(&maxJobs)->default_value(maxJobs),
+			"number of threads to verify a tile with")
 		("help,h", "produce help message")
 		;
 
@@ -273,9 +279,8 @@ int main(int argc, char* argv[]) try
 #pragma region Basic AHN altimetry change location verification
 			{
 				// Operation definition
-				SweepLineCalculation<float> verification(sources, 0,
-					[&approvedBasicCount, &rejectedBasicCount, &approvedBasicSum, &rejectedBasicSum]
-				(int x, int y, const std::vector<Window<float>>& data)
+				SweepLineReduction<float, Verification> verification(sources, 0,
+					[](int x, int y, const std::vector<Window<float>>& data, Verification& result)
 				{
 					const auto& ahn = data[0];
 					if (!ahn.hasData()) return;
@@ -283,148 +288,116 @@ int main(int argc, char* argv[]) try
 					for (int i = 1; i < data.size(); ++i)
 						if (data[i].hasData())
 						{
-							++approvedBasicCount;
-							approvedBasicSum += std::abs(ahn.data());
+							++result.approvedCount;
+							result.approvedSum += std::abs(ahn.data());
 							return;
 						}
-					++rejectedBasicCount;
-					rejectedBasicSum += std::abs(ahn.data());
+					++result.rejectedCount;
+					result.rejectedSum += std::abs(ahn.data());
 				},
+					[](Verification& result, const Verification& other)
+				{
+					result += other;
+				},
+					Verification(),
 					[&reporter, &computationMark, computationSteps](float complete, const std::string &message)
 				{
 					reporter.report(1.f * (computationMark["basic"]) / computationSteps + complete / computationSteps, message);
 					return true;
 				});
 				verification.spatialReference = "EPSG:28992";
+				verification.threadCount = maxJobs;
 
 				// Execute operation
 				verification.execute();
+				approvedBasicCount += verification.result().approvedCount;
+				rejectedBasicCount += verification.result().rejectedCount;
+				approvedBasicSum += verification.result().approvedSum;
+				rejectedBasicSum += verification.result().rejectedSum;
 			}
 #pragma endregion
 
 #pragma region Corrected AHN altimetry change location verification
-			// AHN binarization
-			GDALDataset* ahnCoverage;
-			{
-				SweepLineTransformation<GByte, float> binarization({ ahnDataset }, 0, 
-					[](int x, int y, const std::vector<Window<float>>& data)
-				{
-					const auto& ahn = data[0];
-					return ahn.hasData() ? Coverage::Accept : Coverage::NoData;
-				},
-					[&reporter, &computationMark, computationSteps](float complete, const std::string &message)
-				{
-					reporter.report(1.f * (computationMark["correctedBinarization"]) / computationSteps + complete / computationSteps, message);
-					return true;
-				});
-				binarization.nodataValue = Coverage::NoData;
-
-				// Execute operation
-				binarization.execute();
-				ahnCoverage = binarization.target();
-			}
-
 			// AHN coverage with reference data
-			sources[0] = ahnCoverage;
+			BitMask ahnData(ahnMetadata.rasterSizeX(), ahnMetadata.rasterSizeY());
+			BitMask ahnCoverage(ahnMetadata.rasterSizeX(), ahnMetadata.rasterSizeY());
 			{
-				SweepLineTransformation<GByte> coverage({ sources }, 0, 
-					[](int x, int y, const std::vector<Window<GByte>>& data)
+				SweepLineCalculation<float> coverage(sources, 0,
+					[&ahnData, &ahnCoverage](int x, int y, const std::vector<Window<float>>& data)
 				{
 					const auto& ahn = data[0];
-					if (!ahn.hasData()) return Coverage::NoData;
+					if (!ahn.hasData()) return;
+					ahnData.set(x, y);
 
 					for (int i = 1; i < data.size(); ++i)
 						if (data[i].hasData())
-							return Coverage::Accept;
-					return Coverage::Reject;
+						{
+							ahnCoverage.set(x, y);
+							return;
+						}
 				},
 					[&reporter, &computationMark, computationSteps](float complete, const std::string &message)
 				{
-					reporter.report(1.f * (computationMark["correctedCoverage"]) / computationSteps + complete / computationSteps, message);
+					reporter.report(1.f * (computationMark["correctedBinarization"]) / computationSteps + 2 * complete / computationSteps, message);
 					return true;
 				});
-				coverage.nodataValue = Coverage::NoData;
 				coverage.spatialReference = "EPSG:28992";
 
 				// Execute operation
 				coverage.execute();
-				GDALClose(ahnCoverage);
-				ahnCoverage = coverage.target();
 			}
 
 			// Iterative coverage expansion
-			unsigned int iterations = 0;
-			for(; iterations < 2 * coverageExpansion; ++iterations)
+			for (unsigned int iterations = 0; iterations < 2 * coverageExpansion; ++iterations)
 			{
-				unsigned int change = 0;
-				SweepLineTransformation<GByte> expansion({ ahnCoverage }, 1, 
-					[&change](int x, int y, const std::vector<Window<GByte>>& data)
-				{
-					const auto& coverage = data[0];
-					if (!coverage.hasData()) return Coverage::NoData;
-
-					if(coverage.data() == Coverage::Reject)
-					{
-						if (coverage.data(-1, 0) == Coverage::Accept ||
-							coverage.data(1, 0)  == Coverage::Accept ||
-							coverage.data(0, -1) == Coverage::Accept ||
-							coverage.data(0, 1)  == Coverage::Accept)
-						{
-							++change;
-							return Coverage::Accept;
-						}
-						else
-							return Coverage::Reject;
-					}
-					return Coverage::Accept;
-				},
-					[&reporter, &computationMark, computationSteps, iterations](float complete, const std::string &message)
-				{
-					reporter.report(1.f * (computationMark["correctedExpansion"] + iterations) / computationSteps + complete / computationSteps, message);
-					return true;
-				});
-				expansion.nodataValue = Coverage::NoData;
-				expansion.spatialReference = "EPSG:28992";
-
-				// Execute operation
-				expansion.execute();
-				GDALClose(ahnCoverage);
-				ahnCoverage = expansion.target();
+				// Rejected locations next to an accepted one are accepted
+				BitMask expansion = ahnCoverage.dilate(false);
+				expansion &= ahnData;
+				reporter.report(1.f * (computationMark["correctedExpansion"] + iterations + 1) / computationSteps);
 
 				// Break if no expansion
-				if (change == 0) break;
+				if (expansion == ahnCoverage) break;
+				ahnCoverage = std::move(expansion);
 			}
 
 			// Calculate corrected verification
 			{
-				SweepLineCalculation<float> calculation(std::vector<GDALDataset*>{ ahnDataset, ahnCoverage }, 0,
-					[&approvedCorrectedCount, &rejectedCorrectedCount, &approvedCorrectedSum, &rejectedCorrectedSum]
-				(int x, int y, const std::vector<Window<float>>& data)
+				SweepLineReduction<float, Verification> calculation(std::vector<GDALDataset*>{ ahnDataset }, 0,
+					[&ahnCoverage](int x, int y, const std::vector<Window<float>>& data, Verification& result)
 				{
 					const auto& ahn = data[0];
-					const auto& coverage = data[1];
 					if (!ahn.hasData()) return;
 
-					if (coverage.data() == Coverage::Accept)
+					if (ahnCoverage.get(x, y))
 					{
-						++approvedCorrectedCount;
-						approvedCorrectedSum += std::abs(ahn.data());
+						++result.approvedCount;
+						result.approvedSum += std::abs(ahn.data());
 					}
 					else
 					{
-						++rejectedCorrectedCount;
-						rejectedCorrectedSum += std::abs(ahn.data());
+						++result.rejectedCount;
+						result.rejectedSum += std::abs(ahn.data());
 					}
 				},
+					[](Verification& result, const Verification& other)
+				{
+					result += other;
+				},
+					Verification(),
 					[&reporter, &computationMark, computationSteps](float complete, const std::string &message)
 				{
 					reporter.report(1.f * (computationMark["correctedCalculation"]) / computationSteps + complete / computationSteps, message);
 					return true;
 				});
 				calculation.spatialReference = "EPSG:28992";
+				calculation.threadCount = maxJobs;
 
 				// Execute operation
 				calculation.execute();
+				approvedCorrectedCount += calculation.result().approvedCount;
+				rejectedCorrectedCount += calculation.result().rejectedCount;
+				approvedCorrectedSum += calculation.result().approvedSum;
+				rejectedCorrectedSum += calculation.result().rejectedSum;
 			}
 			reporter.report(1.f);
 #pragma endregion
@@ -435,7 +408,6 @@ int main(int argc, char* argv[]) try
 
 			// Close AHN datasets
 			GDALClose(ahnDataset);
-			GDALClose(ahnCoverage);
 		}
 	}
 
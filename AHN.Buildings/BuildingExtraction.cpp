@@ -1,4 +1,4 @@
-#include <CloudTools.DEM/Window.hpp>
+#include <CloudTools.DEM/RowWindow.hpp>
 
 #include "BuildingExtraction.h"
 
@@ -14,14 +14,14 @@ BuildingExtraction::BuildingExtraction(GDALDataset* surfaceDataset, GDALDataset*
 	: SweepLineTransformation<GByte, float>(std::vector<GDALDataset*>{surfaceDataset, terrainDataset},
 	                                        targetPath, 0, nullptr, progress)
 {
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, GByte* target)
 		{
-			const Window<float>& surface = sources[0];
-			const Window<float>& terrain = sources[1];
+			const GByte* surfaceValid = sources[0].valid();
+			const GByte* terrainValid = sources[1].valid();
+			const GByte nodataValue = static_cast<GByte>(this->nodataValue);
 
-			if (!terrain.hasData() && surface.hasData())
-				return static_cast<GByte>(255);
-			return static_cast<GByte>(this->nodataValue);
+			for (int x = 0; x < sources[0].sizeX(); ++x)
+				target[x] = surfaceValid[x] & !terrainValid[x] ? 255 : nodataValue;
 		};
 	this->nodataValue = 0;
 }
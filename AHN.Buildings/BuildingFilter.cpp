@@ -1,4 +1,5 @@
-#include <CloudTools.DEM/Window.hpp>
+#include <CloudTools.DEM/RowWindow.hpp>
+
 #include "BuildingFilter.h"
 
 using namespace CloudTools::DEM;
@@ -12,10 +13,12 @@ BuildingFilter::BuildingFilter(GDALDataset* sourceDataset,
                                ProgressType progress)
 	: SweepLineTransformation<GByte, float>({sourceDataset}, targetPath, 0, nullptr, progress)
 {
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, GByte* target)
 		{
-			const Window<float>& source = sources[0];
-			return static_cast<GByte>(source.hasData() ? 255 : this->nodataValue);
+			const GByte* valid = sources[0].valid();
+			const GByte nodataValue = static_cast<GByte>(this->nodataValue);
+			for (int x = 0; x < sources[0].sizeX(); ++x)
+				target[x] = valid[x] ? 255 : nodataValue;
 		};
 	this->nodataValue = 0;
 }
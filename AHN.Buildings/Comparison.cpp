@@ -1,6 +1,7 @@
-#include <cmath>
+#include <vector>
 
-#include <CloudTools.DEM/Window.hpp>
+#include <CloudTools.DEM/RowWindow.hpp>
+#include <CloudTools.DEM/Elementwise.hpp>
 #include "Comparison.h"
 
 using namespace CloudTools::DEM;
@@ -14,18 +15,10 @@ Comparison::Comparison(GDALDataset* ahn2Dataset, GDALDataset* ahn3Dataset,
                        ProgressType progress)
 	: SweepLineTransformation<float>(std::vector<GDALDataset*>{ahn2Dataset, ahn3Dataset}, targetPath, 0, nullptr, progress)
 {
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
 		{
-			const Window<float>& ahn2 = sources[0];
-			const Window<float>& ahn3 = sources[1];
-
-			if (!ahn2.hasData() || !ahn3.hasData())
-				return static_cast<float>(this->nodataValue);
-
-			float difference = ahn3.data() - ahn2.data();
-			if (std::abs(difference) >= this->maximumThreshold || std::abs(difference) <= this->minimumThreshold)
-				difference = static_cast<float>(this->nodataValue);
-			return difference;
+			compare(sources, this->minimumThreshold, this->maximumThreshold,
+				static_cast<float>(this->nodataValue), target);
 		};
 	this->nodataValue = 0;
 }
@@ -37,36 +30,75 @@ Comparison::Comparison(GDALDataset* ahn2Dataset, GDALDataset* ahn3Dataset,
 	: SweepLineTransformation<float>(std::vector<GDALDataset*>{ahn2Dataset, ahn3Dataset, ahn2Filter, ahn3Filter},
 	                                 targetPath, 0, nullptr, progress)
 {
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
 		{
-			const Window<float>& ahn2Data = sources[0];
-			const Window<float>& ahn3Data = sources[1];
-			const Window<float>& ahn2Filter = sources[2];
-			const Window<float>& ahn3Filter = sources[3];
-
-			/*
-			 * Since AHN-3 is incomplete, side tiles are partial, 
-			 * resulting in false positive detection of mass building demolition
-			 * when relying only on the filter laysers.
-			 * TODO: this removes demolitions over water (e.g. TU Delft Faculty of Architecture building.)
-			 */
-			if (!ahn2Filter.hasData() && !ahn3Filter.hasData() ||
-				!ahn3Data.hasData())
-				return static_cast<float>(this->nodataValue);
+			compareFiltered(sources, this->minimumThreshold, this->maximumThreshold,
+				static_cast<float>(this->nodataValue), target);
+		};
+	this->nodataValue = 0;
+}
 
-			float difference = 0.f;
-			if (ahn2Data.hasData() && ahn3Data.hasData())
-				difference = ahn3Data.data() - ahn2Data.data();
-			else if (ahn2Data.hasData())
-				difference = -ahn2Data.data();
-			else if (ahn3Data.hasData())
-				difference = ahn3Data.data();
+Comparison::RowComputationType Comparison::createRowComputation(double minimumThreshold, double maximumThreshold,
+                                                                double nodataValue)
+{
+	return [minimumThreshold, maximumThreshold, nodataValue](int y, const std::vector<RowWindow<float>>& sources, float* target)
+		{
+			compare(sources, minimumThreshold, maximumThreshold, static_cast<float>(nodataValue), target);
+		};
+}
 
-			if (std::abs(difference) >= this->maximumThreshold || std::abs(difference) <= this->minimumThreshold)
-				difference = static_cast<float>(this->nodataValue);
-			return difference;
+Comparison::RowComputationType Comparison::createFilteredRowComputation(double minimumThreshold, double maximumThreshold,
+                                                                        double nodataValue)
+{
+	return [minimumThreshold, maximumThreshold, nodataValue](int y, const std::vector<RowWindow<float>>& sources, float* target)
+		{
+			compareFiltered(sources, minimumThreshold, maximumThreshold, static_cast<float>(nodataValue), target);
 		};
-	this->nodataValue = 0;
+}
+
+void Comparison::compare(const std::vector<RowWindow<float>>& sources,
+                         double minimumThreshold, double maximumThreshold, float nodataValue, float* target)
+{
+	const int sizeX = sources[0].sizeX();
+	const GByte* ahn2Valid = sources[0].valid();
+	const GByte* ahn3Valid = sources[1].valid();
+
+	std::vector<GByte> relevant(sizeX);
+	for (int x = 0; x < sizeX; ++x)
+		relevant[x] = ahn2Valid[x] & ahn3Valid[x];
+
+	thresholdedDifference(sources[1].data(), sources[0].data(), relevant.data(), sizeX,
+		minimumThreshold, maximumThreshold, nodataValue, target);
+}
+
+void Comparison::compareFiltered(const std::vector<RowWindow<float>>& sources,
+                                 double minimumThreshold, double maximumThreshold, float nodataValue, float* target)
+{
+	const int sizeX = sources[0].sizeX();
+	const float* ahn2Data = sources[0].data();
+	const GByte* ahn2Valid = sources[0].valid();
+	const GByte* ahn3Valid = sources[1].valid();
+	const GByte* ahn2Filter = sources[2].valid();
+	const GByte* ahn3Filter = sources[3].valid();
+
+	std::vector<GByte> relevant(sizeX);
+	std::vector<float> ahn2Base(sizeX);
+	for (int x = 0; x < sizeX; ++x)
+	{
+		/*
+		 * Since AHN-3 is incomplete, side tiles are partial, 
+		 * resulting in false positive detection of mass building demolition
+		 * when relying only on the filter laysers.
+		 * TODO: this removes demolitions over water (e.g. TU Delft Faculty of Architecture building.)
+		 */
+		relevant[x] = (ahn2Filter[x] | ahn3Filter[x]) & ahn3Valid[x];
+
+		// Missing AHN-2 data counts as zero height
+		ahn2Base[x] = ahn2Valid[x] ? ahn2Data[x] : 0.f;
+	}
+
+	thresholdedDifference(sources[1].data(), ahn2Base.data(), relevant.data(), sizeX,
+		minimumThreshold, maximumThreshold, nodataValue, target);
 }
 } // Buildings
 } // AHN
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <CloudTools.DEM/SweepLineTransformation.hpp>
 
@@ -58,6 +59,39 @@ public:
 
 	Comparison(const Comparison&) = delete;
 	Comparison& operator=(const Comparison&) = delete;
+
+	/// <summary>
+	/// Creates the row computation of the comparison of the AHN-2 and AHN-3 sources,
+	/// e.g. for a stage of a <see cref="CloudTools::DEM::SweepLinePipeline"/>.
+	/// </summary>
+	/// <param name="minimumThreshold">Minimum threshold of change.</param>
+	/// <param name="maximumThreshold">Maximum threshold of change.</param>
+	/// <param name="nodataValue">The nodata value of the result.</param>
+	static RowComputationType createRowComputation(double minimumThreshold = 0.4, double maximumThreshold = 1000,
+	                                               double nodataValue = 0);
+
+	/// <summary>
+	/// Creates the row computation of the comparison of the AHN-2 and AHN-3 sources restricted by their building filters,
+	/// e.g. for a stage of a <see cref="CloudTools::DEM::SweepLinePipeline"/>.
+	/// </summary>
+	/// <param name="minimumThreshold">Minimum threshold of change.</param>
+	/// <param name="maximumThreshold">Maximum threshold of change.</param>
+	/// <param name="nodataValue">The nodata value of the result.</param>
+	static RowComputationType createFilteredRowComputation(double minimumThreshold = 0.4, double maximumThreshold = 1000,
+	                                                       double nodataValue = 0);
+
+private:
+	/// <summary>
+	/// Computes the changes of a row from the AHN-2 and AHN-3 sources.
+	/// </summary>
+	static void compare(const std::vector<CloudTools::DEM::RowWindow<float>>& sources,
+	                    double minimumThreshold, double maximumThreshold, float nodataValue, float* target);
+
+	/// <summary>
+	/// Computes the changes of a row from the AHN-2 and AHN-3 sources and building filters.
+	/// </summary>
+	static void compareFiltered(const std::vector<CloudTools::DEM::RowWindow<float>>& sources,
+	                            double minimumThreshold, double maximumThreshold, float nodataValue, float* target);
 };
 } // Buildings
 } // AHN
@@ -15,6 +15,7 @@
 
 #include <CloudTools.Common/IO/Reporter.h>
 #include <CloudTools.DEM/SweepLineTransformation.hpp>
+#include <CloudTools.DEM/SweepLinePipeline.hpp>
 #include <CloudTools.DEM/Filters/NoiseFilter.hpp>
 #include <CloudTools.DEM/Filters/MajorityFilter.hpp>
 #include <CloudTools.DEM/Filters/ClusterFilter.hpp>
@@ -119,22 +120,62 @@ void Process::onExecute()
 		}
 	}
 
-	// Create basic changeset
-	_progressMessage = "Creating changeset";
+	// Change detection: changeset, noise filtering, cluster filtering,
+	// morphology dilation and majority filtering as a single pipeline
 	newResult("changeset");
+	newResult("noise");
+	newResult("sieve");
+	newResult("cluster");
+	newResult("dilation");
+	newResult("majority");
+	newResult("majority");
 	{
-		Comparison comparison(_ahn2SurfaceDataset, _ahn3SurfaceDataset, 
-							  result("buildings-ahn2").dataset, result("buildings-ahn3").dataset,
-		                      result("changeset").path(), _progress);
-		comparison.minimumThreshold = 1.f;
-		comparison.spatialReference = "EPSG:28992"; // The SRS is given slightly differently for some AHN-2 tiles (but not all).
+		// The stages report their own progress messages, so the progress is not piped
+		SweepLinePipeline<float> pipeline(
+			{ _ahn2SurfaceDataset, _ahn3SurfaceDataset,
+			  result("buildings-ahn2").dataset, result("buildings-ahn3").dataset },
+			result("majority", 1).path(), progress);
+		pipeline.spatialReference = "EPSG:28992"; // The SRS is given slightly differently for some AHN-2 tiles (but not all).
 		if (_ahn2TerrainDataset && _ahn3TerrainDataset &&
 			_ahn2SurfaceDataset == _ahn3SurfaceDataset)
-			comparison.bands = { 1, 3 };
-		configure(comparison);
+			pipeline.bands = { 1, 3 };
+		configure(pipeline);
+		pipeline.intermediateQuantization = quantization;
+
+		// The intermediate results are only written when persisted,
+		// except the noise filtered changeset materialized for the sieve
+		bool persist = persistsIntermediates();
+		pipeline.addStage(0, Comparison::createFilteredRowComputation(1.f), 0,
+		                  false, false, "Creating changeset");
+		if (persist)
+			pipeline.addSink(result("changeset").path());
+		pipeline.addStage(2, NoiseFilter<float>::createComputation(2), 0,
+		                  true, "Noise filtering");
+		pipeline.addSink(result("noise").path());
+		pipeline.addBarrier([this](GDALDataset* noiseDataset)
+		{
+			// The sieve requires the whole noise filtered changeset
+			ClusterFilter<float> filter(noiseDataset, result("sieve").path(), result("cluster").path());
+			filter.nodataValue = 0;
+			configure(filter);
+			filter.quantization = quantization;
 
-		comparison.execute();
-		result("changeset").dataset = comparison.target();
+			filter.execute();
+			return filter.target();
+		}, "Cluster filtering");
+		pipeline.addStage(1, MorphologyFilter<float>::createRowComputation(MorphologyFilter<float>::Dilation), 0,
+		                  true, true, "Morphology dilation");
+		if (persist)
+			pipeline.addSink(result("dilation").path());
+		pipeline.addStage(1, MajorityFilter<float>::createRowComputation(1), 0,
+		                  true, true, "Majority filtering / r=1");
+		if (persist)
+			pipeline.addSink(result("majority", 0).path());
+		pipeline.addStage(2, MajorityFilter<float>::createRowComputation(2), 0,
+		                  true, true, "Majority filtering / r=2");
+
+		pipeline.execute();
+		result("majority", 1).dataset = pipeline.target();
 	}
 	GDALClose(_ahn2SurfaceDataset);
 	if (_ahn3SurfaceDataset != _ahn2SurfaceDataset)
@@ -149,67 +190,12 @@ void Process::onExecute()
 	_ahn3TerrainDataset = nullptr;
 	deleteResult("buildings-ahn2");
 	deleteResult("buildings-ahn3");
-
-	// Noise filtering
-	_progressMessage = "Noise filtering";
-	newResult("noise");
-	{
-		NoiseFilter<float> filter(result("changeset").dataset, result("noise").path(), 2, _progress);
-		configure(filter);
-
-		filter.execute();
-		result("noise").dataset = filter.target();
-	}
 	deleteResult("changeset");
-
-	// Cluster filtering
-	_progressMessage = "Cluster filtering";
-	newResult("sieve");
-	newResult("cluster");
-	{
-		ClusterFilter<float> filter(result("noise").dataset, result("sieve").path(), result("cluster").path(), _progress);
-		filter.nodataValue = 0;
-		configure(filter);
-
-		filter.execute();
-		result("sieve").dataset = filter.filter();
-		result("cluster").dataset = filter.target();
-	}
 	deleteResult("noise");
 	deleteResult("sieve");
-
-	// Morpohology dilation
-	_progressMessage = "Morpohology dilation";
-	newResult("dilation");
-	{
-		MorphologyFilter<float> filter(result("cluster").dataset, result("dilation").path(), MorphologyFilter<float>::Dilation, _progress);
-		configure(filter);
-
-		filter.execute();
-		result("dilation").dataset = filter.target();
-	}
 	deleteResult("cluster");
-
-	// Majority filtering
-	for (int range = 1; range <= 2; ++range)
-	{
-		_progressMessage = "Majority filtering / r=" + std::to_string(range);
-		std::size_t index = newResult("majority");
-		{
-			MajorityFilter<float> filter(
-				index == 0 ? result("dilation").dataset : result("majority", 0).dataset,
-				result("majority", index).path(),
-				range, _progress);
-			configure(filter);
-
-			filter.execute();
-			result("majority", index).dataset = filter.target();
-		}
-		if (index == 0)
-			deleteResult("dilation");
-		else
-			deleteResult("majority", 0);
-	}
+	deleteResult("dilation");
+	deleteResult("majority", 0);
 
 	// Write out the results
 	_progressMessage = "Writing results";
@@ -347,6 +333,11 @@ void FileBasedProcess::configure(CloudTools::DEM::Transformation& transformation
 	transformation.createOptions.insert(std::make_pair("COMPRESS", "DEFLATE"));
 }
 
+bool FileBasedProcess::persistsIntermediates() const
+{
+	return debug;
+}
+
 #pragma endregion
 
 #pragma region StreamedProcess
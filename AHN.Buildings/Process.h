@@ -9,6 +9,7 @@
 #include <CloudTools.Common/Operation.h>
 #include <CloudTools.Common/IO/ResultCollection.h>
 #include <CloudTools.DEM/Transformation.h>
+#include <CloudTools.DEM/Quantization.hpp>
 
 namespace fs = boost::filesystem;
 
@@ -27,6 +28,15 @@ public:
 	/// </summary>
 	ProgressType progress;
 
+	/// <summary>
+	/// Quantization of the intermediate height rasters.
+	/// </summary>
+	/// <remarks>
+	/// When enabled, the change detection rasters are stored as 16 bit integers, halving their memory footprint.
+	/// The building masks and the final result are not affected.
+	/// </remarks>
+	CloudTools::DEM::Quantization quantization;
+
 protected:
 	/// <summary>
 	/// Unique identifier, in most cases the name of the tile to process.
@@ -82,6 +92,15 @@ protected:
 	/// </remarks>
 	virtual void configure(CloudTools::DEM::Transformation& transformation) const = 0;
 
+	/// <summary>
+	/// Determines whether all intermediate results of the change detection are written.
+	/// </summary>
+	/// <remarks>
+	/// The change detection stages are computed in a single pass, so by default only the results
+	/// required by the barriers (e.g. the noise filtered changeset) are materialized.
+	/// </remarks>
+	virtual bool persistsIntermediates() const { return false; }
+
 	/// <summary>
 	/// Routes the C-style GDAL progress reports to the defined reporter.
 	/// </summary>
@@ -224,6 +243,12 @@ protected:
 	/// The targets of these transformations are never final.
 	/// </remarks>
 	void configure(CloudTools::DEM::Transformation& transformation) const override;
+
+	/// <summary>
+	/// Determines whether all intermediate results of the change detection are written.
+	/// </summary>
+	/// <returns><c>true</c> in debug mode, otherwise <c>false</c>.</returns>
+	bool persistsIntermediates() const override;
 };
 
 /// <summary>
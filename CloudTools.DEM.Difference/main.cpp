@@ -19,6 +19,26 @@ namespace fs = boost::filesystem;
 using namespace CloudTools::DEM;
 using namespace CloudTools::IO;
 
+/// <summary>
+/// Creates the difference comparison for a source data type.
+/// </summary>
+struct DifferenceFactory
+{
+	const std::vector<std::string>& inputPaths;
+	const std::string& outputPath;
+	double maximumThreshold;
+	double minimumThreshold;
+
+	template <typename DataType>
+	Transformation* operator()(TypeTag<DataType>) const
+	{
+		auto difference = new Difference<DataType>(inputPaths, outputPath);
+		difference->maximumThreshold = maximumThreshold;
+		difference->minimumThreshold = minimumThreshold;
+		return difference;
+	}
+};
+
 int main(int argc, char* argv[]) try
 {
 	std::vector<std::string> inputPaths;
@@ -26,7 +46,7 @@ int main(int argc, char* argv[]) try
 	std::string outputFormat;
 	std::vector<std::string> outputOptions;
 
-	GDALDataType dataType;
+	GDALDataType dataType = GDALDataType::GDT_Unknown;
 	std::string dataTypeString;
 
 	// Read console arguments
@@ -42,9 +62,10 @@ int main(int argc, char* argv[]) try
 			"http://www.gdal.org/formats_list.html")
 		("max-threshold", po::value<double>()->default_value(1000), "maximum difference threshold")
 		("min-threshold", po::value<double>()->default_value(0), "minimum difference threshold")
-		("datatype,d", po::value<std::string>(&dataTypeString)->default_value("Float32"),
-			"data type of the input and output files, supported:\n"
-		    "Int16, Int32, Float32, Float64")
+		("datatype,d", po::value<std::string>(&dataTypeString),
+			"data type of the computation, supported:\n"
+			"Byte, UInt16, Int16, UInt32, Int32, Float32, Float64;\n"
+			"the type of the first input file by default")
 		("nodata-value", po::value<double>(), "specifies the nodata value")
 		("srs", po::value<std::string>(), "override spatial reference system")
 		("verbose,v", "verbose output")
@@ -57,7 +78,8 @@ int main(int argc, char* argv[]) try
 	po::notify(vm);
 
 	// Post-processing arguments
-	dataType = gdalType(dataTypeString);
+	if (vm.count("datatype"))
+		dataType = gdalType(dataTypeString);
 
 	// Argument validation
 	if (vm.count("help"))
@@ -74,7 +96,7 @@ int main(int argc, char* argv[]) try
 		argumentError = true;
 	}
 
-	if (dataType == GDALDataType::GDT_Unknown)
+	if (vm.count("datatype") && dataType == GDALDataType::GDT_Unknown)
 	{
 		std::cerr << "Unrecognized data type." << std::endl;
 		argumentError = true;
@@ -94,48 +116,25 @@ int main(int argc, char* argv[]) try
 		? static_cast<Reporter*>(new TextReporter())
 		: static_cast<Reporter*>(new BarReporter());
 
-	// Define comparer with corresponding data type
+	// Read input data type
 	GDALAllRegister();
-	Transformation *comparison;	
-	switch (dataType)
+	if (dataType == GDALDataType::GDT_Unknown)
+	{
+		GDALDataset* inputDataset = static_cast<GDALDataset*>(GDALOpen(inputPaths.front().c_str(), GA_ReadOnly));
+		if (inputDataset == nullptr)
+			throw std::runtime_error("Error at opening the input file.");
+		dataType = inputDataset->GetRasterBand(1)->GetRasterDataType();
+		GDALClose(inputDataset);
+	}
+
+	// Define comparer with corresponding data type
+	if (!isSupportedType(dataType))
 	{
-	case GDALDataType::GDT_Int16:
-		{
-			auto difference = new Difference<GInt16>(inputPaths, outputPath);
-			difference->maximumThreshold = vm["max-threshold"].as<double>();
-			difference->minimumThreshold = vm["min-threshold"].as<double>();
-			comparison = difference;
-			break;
-		}
-	case GDALDataType::GDT_Int32:
-		{
-			auto difference = new Difference<GInt32>(inputPaths, outputPath);
-			difference->maximumThreshold = vm["max-threshold"].as<double>();
-			difference->minimumThreshold = vm["min-threshold"].as<double>();
-			comparison = difference;
-			break;
-		}
-	case GDALDataType::GDT_Float32:
-		{
-			auto difference = new Difference<float>(inputPaths, outputPath);
-			difference->maximumThreshold = vm["max-threshold"].as<double>();
-			difference->minimumThreshold = vm["min-threshold"].as<double>();
-			comparison = difference;
-			break;
-		}
-	case GDALDataType::GDT_Float64:
-		{
-			auto difference = new Difference<double>(inputPaths, outputPath);
-			difference->maximumThreshold = vm["max-threshold"].as<double>();
-			difference->minimumThreshold = vm["min-threshold"].as<double>();
-			comparison = difference;
-			break;
-		}
-	default:
-		// Unsigned and complex types are not supported.
 		std::cerr << "Unsupported data type given." << std::endl;
 		return Unsupported;
 	}
+	Transformation *comparison = dispatchType(dataType, DifferenceFactory{ inputPaths, outputPath,
+		vm["max-threshold"].as<double>(), vm["min-threshold"].as<double>() });
 
 	comparison->targetFormat = outputFormat;
 	if (vm.count("nodata-value"))
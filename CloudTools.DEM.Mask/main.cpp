@@ -15,7 +15,8 @@
 #include <CloudTools.DEM/Metadata.h>
 #include <CloudTools.DEM/Rasterize.h>
 #include <CloudTools.DEM/SweepLineTransformation.hpp>
-#include <CloudTools.DEM/Window.hpp>
+#include <CloudTools.DEM/RowWindow.hpp>
+#include <CloudTools.DEM/Elementwise.hpp>
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -23,6 +24,37 @@ namespace fs = boost::filesystem;
 using namespace CloudTools::DEM;
 using namespace CloudTools::IO;
 
+/// <summary>
+/// Creates the mask transformation for a source data type.
+/// </summary>
+struct MaskFactory
+{
+	const std::string& inputPath;
+	const std::string& maskRasterPath;
+	const std::string& outputPath;
+	bool invert;
+
+	template <typename DataType>
+	Transformation* operator()(TypeTag<DataType>) const
+	{
+		bool invert = this->invert;
+		auto mask = new SweepLineTransformation<DataType>({ inputPath, maskRasterPath }, outputPath, nullptr);
+		mask->rowComputation = [invert, mask](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
+		{
+			const int sizeX = sources[0].sizeX();
+			const GByte* dataValid = sources[0].valid();
+			const GByte* maskValid = sources[1].valid();
+			const GByte inverted = invert ? 1 : 0;
+
+			std::vector<GByte> condition(sizeX);
+			for (int x = 0; x < sizeX; ++x)
+				condition[x] = dataValid[x] & (maskValid[x] ^ inverted);
+			selectValid(sources[0].data(), condition.data(), sizeX, static_cast<DataType>(mask->nodataValue), target);
+		};
+		return mask;
+	}
+};
+
 int main(int argc, char* argv[]) try
 {
 	std::string inputPath;
@@ -191,58 +223,13 @@ int main(int argc, char* argv[]) try
 	GDALClose(inputDataset);
 
 	// Define mask with corresponding data type
-	Transformation *mask;
-	switch (dataType)
-	{
-	case GDALDataType::GDT_Int16:
+	if (!isSupportedType(dataType))
 	{
-		mask = new SweepLineTransformation<GInt16>({ inputPath, maskRasterPath }, outputPath,
-			[&vm, &mask](int x, int y, const std::vector<Window<GInt16>>& sources)
-		{
-			return (!vm.count("invert") ? sources[1].hasData() : !sources[1].hasData()) && sources[0].hasData()
-				? sources[0].data()
-				: static_cast<GInt16>(mask->nodataValue);
-		});
-		break;
-	}
-	case GDALDataType::GDT_Int32:
-	{
-		mask = new SweepLineTransformation<GInt32>({ inputPath, maskRasterPath }, outputPath,
-			[&vm, &mask](int x, int y, const std::vector<Window<GInt32>>& sources)
-		{
-			return (!vm.count("invert") ? sources[1].hasData() : !sources[1].hasData()) && sources[0].hasData()
-				? sources[0].data()
-				: static_cast<GInt32>(mask->nodataValue);
-		});
-		break;
-	}
-	case GDALDataType::GDT_Float32:
-	{
-		mask = new SweepLineTransformation<float>({ inputPath, maskRasterPath }, outputPath,
-			[&vm, &mask](int x, int y, const std::vector<Window<float>>& sources)
-		{
-			return (!vm.count("invert") ? sources[1].hasData() : !sources[1].hasData()) && sources[0].hasData()
-				? sources[0].data()
-				: static_cast<float>(mask->nodataValue);
-		});
-		break;
-	}
-	case GDALDataType::GDT_Float64:
-	{
-		mask = new SweepLineTransformation<double>({ inputPath, maskRasterPath }, outputPath,
-			[&vm, &mask](int x, int y, const std::vector<Window<double>>& sources)
-		{
-			return (!vm.count("invert") ? sources[1].hasData() : !sources[1].hasData()) && sources[0].hasData()
-				? sources[0].data()
-				: mask->nodataValue;
-		});
-		break;
-	}
-	default:
-		// Unsigned and complex types are not supported.
 		std::cerr << "Unsupported data type given." << std::endl;
 		return Unsupported;
 	}
+	Transformation *mask = dispatchType(dataType,
+		MaskFactory{ inputPath, maskRasterPath, outputPath, vm.count("invert") > 0 });
 
 	if (vm.count("nodata-value"))
 		mask->nodataValue = vm["nodata-value"].as<double>();
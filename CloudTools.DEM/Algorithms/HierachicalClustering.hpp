@@ -1,9 +1,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 #include "../DatasetTransformation.hpp"
-#include "../ClusterMap.h"
+#include "../ComponentLabeling.hpp"
 
 namespace CloudTools
 {
@@ -12,6 +15,13 @@ namespace DEM
 /// <summary>
 /// Represents a hierarchical clustering for DEM datasets.
 /// </summary>
+/// <remarks>
+/// The agglomerative clustering merges the horizontally, vertically and (towards the lower right) diagonally
+/// neighboring points with height difference below <see cref="threshold"/> until no more merges are possible,
+/// i.e. the clusters are the connected components of this neighborhood graph. The components are labeled
+/// by a <see cref="ComponentLabeling"/> with <see cref="threadCount"/> threads.
+/// The clusters are numbered from 1 in row-major order of their first point.
+/// </remarks>
 template <typename DataType = float>
 class HierarchicalClustering : public DatasetTransformation<GUInt32, DataType>
 {
@@ -35,6 +45,9 @@ public:
 	/// <summary>
 	/// The maximum number of iterations to be applied in the algorithm.
 	/// </summary>
+	/// <remarks>
+	/// Obsolete, the clustering always converges in two passes.
+	/// </remarks>
 	int maxIterations = 100;
 
 	/// <summary>
@@ -93,94 +106,59 @@ void HierarchicalClustering<DataType>::initialize()
 	this->nodataValue = 0;
 
 	// https://en.wikipedia.org/wiki/Hierarchical_clustering
+	// https://en.wikipedia.org/wiki/Connected-component_labeling
 	this->computation = [this](int sizeX, int sizeY)
 	{
-		if (this->maxIterations < 1)
-			this->maxIterations = 1;
-
-		ClusterMap clusterMap;
+		std::vector<ComponentLabeling::LabelType> labels;
+		std::size_t clusterCount = 0;
 
 		switch (method)
 		{
 		case Method::Agglomerative:
 		{
-			for (int i = 0; i < sizeX; ++i)
-				for (int j = 0; j < sizeY; ++j)
-					if (this->hasSourceData(i, j))
-					{
-						clusterMap.createCluster(i, j);
-					}
-
-			auto mergeClusters = [this, &clusterMap](int x1, int y1, int x2, int y2)
-			{
-				if (this->hasSourceData(x1, y1) && this->hasSourceData(x2, y2) &&
-					clusterMap.clusterIndex(x1, y1) != clusterMap.clusterIndex(x2, y2))
+			ComponentLabeling labeling(ComponentLabeling::Connectivity::Eight, this->threadCount);
+			clusterCount = labeling.label(sizeX, sizeY,
+				[this](int x, int y)
 				{
-					DataType diff = std::abs(this->sourceData(x1, y1) - this->sourceData(x2, y2));
-					if (diff < this->threshold)
-					{
-						clusterMap.mergeClusters(
-							clusterMap.clusterIndex(x1, y1),
-							clusterMap.clusterIndex(x2, y2));
-
-						return true;
-					}
-				}
-				return false;
-			};
-			if (this->progress)
-				this->progress(0.1f, "Cluster map created");
-
-			int changes;
-			int iteration = 0;
-			do
-			{
-				changes = 0;
-				++iteration;
-
-				for (int i = 0; i < sizeX; ++i)
-					for (int j = 0; j < sizeY; ++j)
-						if (this->hasSourceData(i, j))
-						{
-							/*
-							 * Right & downwards merge direction:
-							 * o 1
-							 * 2 3
-							 */
-
-							bool merged = false;
-							merged |= mergeClusters(i, j, i, j + 1);
-							merged |= mergeClusters(i, j, i + 1, j);
-							merged |= mergeClusters(i, j, i + 1, j + 1);
-
-							if (merged)
-								++changes;
-						}
-
-				if (this->progress)
-					this->progress(0.1f + 0.8f / this->maxIterations,
-						"Finished clustering round #" + std::to_string(iteration) +
-						" with " + std::to_string(changes) + " changes");
-			} while (changes > 0 && iteration < this->maxIterations);
-
+					return this->hasSourceData(x, y);
+				},
+				[this](int x, int y, int nx, int ny)
+				{
+					// The diagonal towards the lower left is not a neighborhood
+					if ((nx - x) * (ny - y) < 0)
+						return false;
+					DataType diff = std::abs(this->sourceData(x, y) - this->sourceData(nx, ny));
+					return diff < this->threshold;
+				},
+				labels);
 			break;
 		}
 		}
 		if (this->progress)
-			this->progress(0.9f, "Clustering completed");
+			this->progress(0.8f, "Clustering completed");
+
+		// Number the clusters large enough in the order of appearance
+		std::vector<std::size_t> clusterSizes(clusterCount + 1, 0);
+		for (ComponentLabeling::LabelType label : labels)
+			++clusterSizes[label];
+
+		std::vector<GUInt32> indexes(clusterCount + 1, 0);
+		GUInt32 nextIndex = 1;
+		for (std::size_t label = 1; label <= clusterCount; ++label)
+			if (clusterSizes[label] >= static_cast<std::size_t>(std::max(this->minimumSize, 1)))
+				indexes[label] = nextIndex++;
+		if (this->progress)
+			this->progress(0.9f, "Small clusters removed");
 
-		if (this->minimumSize > 1)
+		this->parallelFor(sizeY, [this, sizeX, &labels, &indexes](int j)
 		{
-			clusterMap.removeSmallClusters(this->minimumSize);
-			if (this->progress)
-				this->progress(0.95f, "Small clusters removed");
-		}
-
-		for (GUInt32 index : clusterMap.clusterIndexes())
-			for (const OGRPoint& point : clusterMap.points(index))
+			for (int i = 0; i < sizeX; ++i)
 			{
-				this->setTargetData(point.getX(), point.getY(), index);
+				GUInt32 index = indexes[labels[static_cast<std::size_t>(j) * sizeX + i]];
+				if (index)
+					this->setTargetData(i, j, index);
 			}
+		});
 
 		if (this->progress)
 			this->progress(1.f, "Target created");
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <gdal_priv.h>
+#include <ogr_geometry.h>
+
+#include <CloudTools.Common/Operation.h>
+#include "../SweepLineReduction.hpp"
+#include "../Filters/ExtremumFilter.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Collects the local maxima of a DEM dataset.
+/// </summary>
+/// <remarks>
+/// A position with valid data is a local maximum if no valid data in the <c>(2 * range + 1)^2</c> sized window
+/// around it is greater. The window maxima are computed first by an <see cref="ExtremumFilter"/> into an in memory raster,
+/// then the positions equal to their window maximum are collected in row-major order.
+/// </remarks>
+/// <param name="sourceDataset">The source dataset.</param>
+/// <param name="range">The range of the window.</param>
+/// <param name="threadCount">The number of worker threads.</param>
+/// <param name="progress">The callback method to report progress.</param>
+/// <returns>The local maxima with the raster coordinates and the value of the positions.</returns>
+template <typename DataType = float>
+std::vector<OGRPoint> localMaxima(GDALDataset* sourceDataset, int range,
+                                  unsigned int threadCount = 1,
+                                  Operation::ProgressType progress = nullptr)
+{
+	ExtremumFilter<DataType> maximum(sourceDataset, range, ExtremumFilter<DataType>::Method::Maximum);
+	maximum.threadCount = threadCount;
+	if (progress)
+		maximum.progress = [&progress](float complete, const std::string& message)
+		{
+			return progress(complete / 2, message);
+		};
+	maximum.execute();
+
+	SweepLineReduction<DataType, std::vector<OGRPoint>> collection(
+		std::vector<GDALDataset*>{ sourceDataset, maximum.target() }, 0,
+		[](int x, int y, const std::vector<Window<DataType>>& sources, std::vector<OGRPoint>& points)
+		{
+			const Window<DataType>& source = sources[0];
+			if (source.hasData() && sources[1].hasData() && !(sources[1].data() > source.data()))
+				points.emplace_back(x, y, source.data());
+		},
+		[](std::vector<OGRPoint>& points, const std::vector<OGRPoint>& other)
+		{
+			points.insert(points.end(), other.begin(), other.end());
+		});
+	collection.threadCount = threadCount;
+	if (progress)
+		collection.progress = [&progress](float complete, const std::string& message)
+		{
+			return progress(0.5f + complete / 2, message);
+		};
+	collection.execute();
+	return collection.result();
+}
+} // DEM
+} // CloudTools
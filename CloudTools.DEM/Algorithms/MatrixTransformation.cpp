@@ -1,4 +1,9 @@
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
 #include "../Window.hpp"
+#include "../BoxStatistics.hpp"
 #include "MatrixTransformation.h"
 
 using namespace CloudTools::DEM;
@@ -35,5 +40,129 @@ void MatrixTransformation::initialize()
 	};
 	this->nodataValue = 0;
 }
+
+void MatrixTransformation::setMatrix(const std::vector<float>& horizontal, const std::vector<float>& vertical)
+{
+	const int matrixSize = 2 * _range + 1;
+	if (horizontal.size() != static_cast<std::size_t>(matrixSize) ||
+	    vertical.size() != static_cast<std::size_t>(matrixSize))
+		throw std::invalid_argument("The size of the vectors must match with the size of the kernel.");
+
+	for (int i = 0; i < matrixSize; ++i)
+		for (int j = 0; j < matrixSize; ++j)
+			_matrix[i * matrixSize + j] = horizontal[i] * vertical[j];
+}
+
+void MatrixTransformation::onExecute()
+{
+	const int matrixSize = 2 * _range + 1;
+	this->columnStatistics = _matrix[0] != 0 &&
+		std::all_of(_matrix, _matrix + matrixSize * matrixSize, [this](float value) { return value == _matrix[0]; });
+
+	if (this->columnStatistics)
+	{
+		this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
+		{
+			this->computeUniform(y, sources, target);
+		};
+	}
+	else if (factorize(_horizontal, _vertical))
+	{
+		this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
+		{
+			this->computeSeparable(y, sources, target);
+		};
+	}
+	else
+		this->rowComputation = nullptr;
+
+	SweepLineTransformation<float>::onExecute();
+}
+
+bool MatrixTransformation::factorize(std::vector<float>& horizontal, std::vector<float>& vertical) const
+{
+	const int matrixSize = 2 * _range + 1;
+	const float* pivot = std::max_element(_matrix, _matrix + matrixSize * matrixSize,
+		[](float a, float b) { return std::abs(a) < std::abs(b); });
+	if (*pivot == 0)
+		return false;
+
+	// Factor by the row and the column of the largest element
+	const int pivotI = static_cast<int>(pivot - _matrix) / matrixSize;
+	const int pivotJ = static_cast<int>(pivot - _matrix) % matrixSize;
+	horizontal.resize(matrixSize);
+	vertical.resize(matrixSize);
+	for (int k = 0; k < matrixSize; ++k)
+	{
+		horizontal[k] = _matrix[k * matrixSize + pivotJ] / *pivot;
+		vertical[k] = _matrix[pivotI * matrixSize + k];
+	}
+
+	const float tolerance = 1e-6f * std::abs(*pivot);
+	for (int i = 0; i < matrixSize; ++i)
+		for (int j = 0; j < matrixSize; ++j)
+			if (std::abs(_matrix[i * matrixSize + j] - horizontal[i] * vertical[j]) > tolerance)
+				return false;
+	return true;
+}
+
+void MatrixTransformation::computeUniform(int y, const std::vector<RowWindow<float>>& sources, float* target) const
+{
+	const RowWindow<float>& source = sources[0];
+	const int sizeX = source.sizeX();
+
+	// The weights cancel out, the result is the mean of the valid data in the box
+	std::vector<double> sums(sizeX);
+	std::vector<int> counters(sizeX);
+	boxStatistics(source, sums.data(), counters.data());
+
+	const GByte* center = source.valid(0);
+	for (int x = 0; x < sizeX; ++x)
+		target[x] = center[x]
+			? static_cast<float>(sums[x] / counters[x])
+			: static_cast<float>(this->nodataValue);
+}
+
+void MatrixTransformation::computeSeparable(int y, const std::vector<RowWindow<float>>& sources, float* target) const
+{
+	const RowWindow<float>& source = sources[0];
+	const int sizeX = source.sizeX();
+	const int paddedSizeX = sizeX + 2 * _range;
+
+	// Vertical pass over the columns of the window, accumulating the values and the weights
+	// of the valid data, so the nodata positions are excluded from the normalization
+	std::vector<float> values(paddedSizeX, 0.f), weights(paddedSizeX, 0.f);
+	for (int j = -_range; j <= _range; ++j)
+	{
+		const float factor = _vertical[_range + j];
+		const float* data = source.data(j) - _range;
+		const GByte* valid = source.valid(j) - _range;
+		for (int x = 0; x < paddedSizeX; ++x)
+		{
+			values[x] += valid[x] ? data[x] * factor : 0.f;
+			weights[x] += valid[x] * factor;
+		}
+	}
+
+	// Horizontal pass
+	const GByte* center = source.valid(0);
+	for (int x = 0; x < sizeX; ++x)
+	{
+		if (!center[x])
+		{
+			target[x] = static_cast<float>(this->nodataValue);
+			continue;
+		}
+
+		float value = 0;
+		float counter = 0;
+		for (int i = -_range; i <= _range; ++i)
+		{
+			value += values[x + _range + i] * _horizontal[_range + i];
+			counter += weights[x + _range + i] * _horizontal[_range + i];
+		}
+		target[x] = value / counter;
+	}
+}
+}
 }
-}
\ No newline at end of file
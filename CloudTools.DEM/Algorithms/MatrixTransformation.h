@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <vector>
 #include "../SweepLineTransformation.hpp"
 
 namespace CloudTools
@@ -10,6 +11,11 @@ namespace DEM
 /// <summary>
 /// Convolution matrix transformation.
 /// </summary>
+/// <remarks>
+/// Separable (rank-1) kernels are detected at execution and applied by a vertical and a horizontal
+/// one dimensional pass per target row, reducing the cost per pixel from quadratic to linear in the range.
+/// Uniform kernels are applied by sliding box sums in constant time per pixel.
+/// </remarks>
 class MatrixTransformation : public SweepLineTransformation<float>
 {
 private:
@@ -18,6 +24,11 @@ private:
 	/// </summary>
 	float* _matrix;
 
+	/// <summary>
+	/// Horizontal and vertical factors of a separable kernel.
+	/// </summary>
+	std::vector<float> _horizontal, _vertical;
+
 public:
 	/// <summary>
 	/// Initializes a new instance of the class. Loads input metadata and defines calculation.
@@ -79,8 +90,45 @@ public:
 		_matrix[(_range + i) * matrixSize + (_range + j)] = value;
 	}
 
+	/// <summary>
+	/// Sets a separable kernel as the outer product of a horizontal and a vertical vector.
+	/// </summary>
+	/// <param name="horizontal">The factors by horizontal offset from <c>-range</c> to <c>range</c>.</param>
+	/// <param name="vertical">The factors by vertical offset from <c>-range</c> to <c>range</c>.</param>
+	void setMatrix(const std::vector<float>& horizontal, const std::vector<float>& vertical);
+
+	/// <summary>
+	/// Determines whether the kernel is separable, i.e. it is the outer product of two vectors.
+	/// </summary>
+	bool isSeparable() const
+	{
+		std::vector<float> horizontal, vertical;
+		return factorize(horizontal, vertical);
+	}
+
+protected:
+	/// <summary>
+	/// Selects the computation method by the kernel and produces the target.
+	/// </summary>
+	void onExecute() override;
+
 private:
 	void initialize();
+
+	/// <summary>
+	/// Decomposes the kernel into a horizontal and a vertical vector if it is separable.
+	/// </summary>
+	bool factorize(std::vector<float>& horizontal, std::vector<float>& vertical) const;
+
+	/// <summary>
+	/// Computes a target row with a uniform kernel.
+	/// </summary>
+	void computeUniform(int y, const std::vector<RowWindow<float>>& sources, float* target) const;
+
+	/// <summary>
+	/// Computes a target row with a separable kernel.
+	/// </summary>
+	void computeSeparable(int y, const std::vector<RowWindow<float>>& sources, float* target) const;
 };
 }
 }
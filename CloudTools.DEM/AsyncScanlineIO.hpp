@@ -0,0 +1,277 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <future>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include "BoundedQueue.hpp"
+#include "ValidityMask.hpp"
+#include "Helper.h"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a background reader of consecutive scanlines of a raster band.
+/// </summary>
+/// <remarks>
+/// The scanlines are read ahead by a background thread into a bounded queue,
+/// so the decoding of the source overlaps with the computation on the consumer thread.
+/// The scanlines must be retrieved sequentially in ascending order.
+/// </remarks>
+template <typename DataType>
+class ScanlinePrefetcher
+{
+private:
+	struct Item
+	{
+		int row;
+		int slot;
+		CPLErr result;
+	};
+
+	GDALRasterBand* _band;
+	GDALRasterBand* _maskBand;
+	std::mutex* _bandMutex;
+	int _firstRow;
+	int _lastRow;
+	int _firstColumn;
+	int _columnCount;
+
+	std::vector<DataType> _data;
+	std::vector<GByte> _mask;
+	BoundedQueue<int> _free;
+	BoundedQueue<Item> _filled;
+	std::future<void> _reader;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class and starts reading ahead.
+	/// </summary>
+	/// <param name="band">The raster band to read the scanlines from.</param>
+	/// <param name="firstRow">The first scanline to read.</param>
+	/// <param name="lastRow">The scanline after the last scanline to read.</param>
+	/// <param name="firstColumn">The first column to read.</param>
+	/// <param name="columnCount">The number of columns to read.</param>
+	/// <param name="depth">The maximal number of scanlines to read ahead.</param>
+	/// <param name="bandMutex">The mutex guarding the band when shared between threads.</param>
+	ScanlinePrefetcher(GDALRasterBand* band,
+	                   int firstRow, int lastRow,
+	                   int firstColumn, int columnCount,
+	                   int depth, std::mutex* bandMutex = nullptr)
+		: _band(band), _maskBand(validityMaskBand(band)), _bandMutex(bandMutex),
+		  _firstRow(firstRow), _lastRow(lastRow),
+		  _firstColumn(firstColumn), _columnCount(columnCount),
+		  _data(static_cast<std::size_t>(columnCount) * depth),
+		  _free(depth), _filled(depth)
+	{
+		if (_maskBand != nullptr)
+			_mask.resize(_data.size());
+		for (int slot = 0; slot < depth; ++slot)
+			_free.push(slot);
+
+		_reader = std::async(std::launch::async, &ScanlinePrefetcher::run, this);
+	}
+
+	ScanlinePrefetcher(const ScanlinePrefetcher&) = delete;
+	ScanlinePrefetcher& operator=(const ScanlinePrefetcher&) = delete;
+
+	~ScanlinePrefetcher()
+	{
+		_free.close();
+		_filled.close();
+		if (_reader.valid())
+			_reader.wait();
+	}
+
+	/// <summary>
+	/// Retrieves the next scanline.
+	/// </summary>
+	/// <param name="row">The index of the requested scanline, must be the next one in order.</param>
+	/// <param name="target">The target buffer of the data.</param>
+	/// <param name="mask">The target buffer of the mask band values, <c>nullptr</c> if not required.</param>
+	/// <returns>The result of the raster I/O operations.</returns>
+	CPLErr read(int row, DataType* target, GByte* mask = nullptr)
+	{
+		Item item;
+		if (!_filled.pop(item))
+		{
+			// Propagate the failure of the reader if any
+			_reader.get();
+			throw std::logic_error("The requested scanline is out of the prefetched range.");
+		}
+		if (item.row != row)
+			throw std::logic_error("The scanlines must be retrieved sequentially.");
+
+		std::size_t offset = static_cast<std::size_t>(item.slot) * _columnCount;
+		std::copy(_data.begin() + offset, _data.begin() + offset + _columnCount, target);
+		if (mask != nullptr && _maskBand != nullptr)
+			std::copy(_mask.begin() + offset, _mask.begin() + offset + _columnCount, mask);
+
+		_free.push(item.slot);
+		return item.result;
+	}
+
+private:
+	void run()
+	{
+		try
+		{
+			for (int row = _firstRow; row < _lastRow; ++row)
+			{
+				Item item;
+				if (!_free.pop(item.slot))
+					return;
+				item.row = row;
+
+				std::size_t offset = static_cast<std::size_t>(item.slot) * _columnCount;
+				std::unique_lock<std::mutex> lock;
+				if (_bandMutex != nullptr)
+					lock = std::unique_lock<std::mutex>(*_bandMutex);
+
+				item.result = _band->RasterIO(GF_Read,
+					_firstColumn, row,
+					_columnCount, 1,
+					&_data[offset], _columnCount, 1,
+					gdalType<DataType>(), 0, 0);
+				if (_maskBand != nullptr)
+					item.result = static_cast<CPLErr>(item.result | _maskBand->RasterIO(GF_Read,
+						_firstColumn, row,
+						_columnCount, 1,
+						&_mask[offset], _columnCount, 1,
+						GDT_Byte, 0, 0));
+				if (lock.owns_lock())
+					lock.unlock();
+
+				if (!_filled.push(item))
+					return;
+			}
+			_filled.close();
+		}
+		catch (...)
+		{
+			_filled.close();
+			throw;
+		}
+	}
+};
+
+/// <summary>
+/// Represents a background writer of scanlines of a raster band.
+/// </summary>
+/// <remarks>
+/// The finished scanlines are written by a background thread from a bounded queue,
+/// so the encoding of the target overlaps with the computation on the producer thread.
+/// </remarks>
+template <typename DataType>
+class ScanlineWriter
+{
+private:
+	struct Item
+	{
+		int row;
+		DataType* data;
+	};
+
+	GDALRasterBand* _band;
+	std::mutex* _bandMutex;
+	int _sizeX;
+	CPLErr _result;
+
+	std::vector<DataType> _data;
+	BoundedQueue<DataType*> _free;
+	BoundedQueue<Item> _filled;
+	std::future<void> _writer;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class and starts the writer.
+	/// </summary>
+	/// <param name="band">The raster band to write the scanlines to.</param>
+	/// <param name="depth">The maximal number of scanlines waiting to be written.</param>
+	/// <param name="bandMutex">The mutex guarding the band when shared between threads.</param>
+	ScanlineWriter(GDALRasterBand* band, int depth, std::mutex* bandMutex = nullptr)
+		: _band(band), _bandMutex(bandMutex),
+		  _sizeX(band->GetXSize()), _result(CE_None),
+		  _data(static_cast<std::size_t>(_sizeX) * depth),
+		  _free(depth), _filled(depth)
+	{
+		for (int slot = 0; slot < depth; ++slot)
+			_free.push(_data.data() + static_cast<std::size_t>(slot) * _sizeX);
+
+		_writer = std::async(std::launch::async, &ScanlineWriter::run, this);
+	}
+
+	ScanlineWriter(const ScanlineWriter&) = delete;
+	ScanlineWriter& operator=(const ScanlineWriter&) = delete;
+
+	~ScanlineWriter()
+	{
+		_filled.close();
+		if (_writer.valid())
+			_writer.wait();
+	}
+
+	/// <summary>
+	/// Retrieves a free scanline buffer to fill, waits while all buffers are in use.
+	/// </summary>
+	DataType* acquire()
+	{
+		DataType* buffer;
+		if (!_free.pop(buffer))
+			throw std::logic_error("The writer is already finished.");
+		return buffer;
+	}
+
+	/// <summary>
+	/// Queues a filled scanline buffer for writing.
+	/// </summary>
+	/// <param name="row">The index of the scanline.</param>
+	/// <param name="buffer">The buffer retrieved by <see cref="acquire"/>.</param>
+	void write(int row, DataType* buffer)
+	{
+		if (!_filled.push(Item{ row, buffer }))
+			throw std::logic_error("The writer is already finished.");
+	}
+
+	/// <summary>
+	/// Waits until all queued scanlines are written.
+	/// </summary>
+	void finish()
+	{
+		_filled.close();
+		_writer.get();
+		if (_result != CE_None)
+			throw std::runtime_error("Target write error occured.");
+	}
+
+private:
+	void run()
+	{
+		Item item;
+		while (_filled.pop(item))
+		{
+			CPLErr result;
+			{
+				std::unique_lock<std::mutex> lock;
+				if (_bandMutex != nullptr)
+					lock = std::unique_lock<std::mutex>(*_bandMutex);
+
+				result = _band->RasterIO(GF_Write,
+					0, item.row,
+					_sizeX, 1,
+					item.data, _sizeX, 1,
+					gdalType<DataType>(), 0, 0);
+			}
+			_result = static_cast<CPLErr>(_result | result);
+			_free.push(item.data);
+		}
+	}
+};
+} // DEM
+} // CloudTools
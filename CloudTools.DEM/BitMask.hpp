@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a binary raster packed to 1 bit per position in 64 bit words.
+/// </summary>
+/// <remarks>
+/// The rows start on word boundaries, so different rows never share a word and can be modified concurrently.
+/// Bit <c>x % 64</c> of word <c>x / 64</c> in a row belongs to the column <c>x</c>.
+/// The morphology kernels process 64 positions per word operation; positions outside of the raster are considered unset.
+/// </remarks>
+class BitMask
+{
+public:
+	typedef std::uint64_t WordType;
+
+private:
+	static const int wordBits = 64;
+
+	int _sizeX;
+	int _sizeY;
+	int _stride;
+	std::vector<WordType> _words;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="sizeX">The width of the mask.</param>
+	/// <param name="sizeY">The height of the mask.</param>
+	/// <param name="value">The initial value of the positions.</param>
+	BitMask(int sizeX = 0, int sizeY = 0, bool value = false)
+		: _sizeX(sizeX), _sizeY(sizeY), _stride((sizeX + wordBits - 1) / wordBits),
+		  _words(static_cast<std::size_t>(_stride) * sizeY)
+	{
+		if (sizeX < 0 || sizeY < 0)
+			throw std::invalid_argument("The size of the mask must be non-negative.");
+		fill(value);
+	}
+
+	/// <summary>
+	/// Gets the width of the mask.
+	/// </summary>
+	int sizeX() const { return _sizeX; }
+
+	/// <summary>
+	/// Gets the height of the mask.
+	/// </summary>
+	int sizeY() const { return _sizeY; }
+
+	/// <summary>
+	/// Gets the number of words in a row.
+	/// </summary>
+	int stride() const { return _stride; }
+
+	/// <summary>
+	/// Retrieves the words of a row.
+	/// </summary>
+	/// <remarks>
+	/// The bits beyond the width of the mask in the last word must remain unset.
+	/// </remarks>
+	WordType* row(int y) { return _words.data() + static_cast<std::size_t>(y) * _stride; }
+	const WordType* row(int y) const { return _words.data() + static_cast<std::size_t>(y) * _stride; }
+
+	/// <summary>
+	/// Retrieves the value of a position.
+	/// </summary>
+	/// <returns><c>false</c> for positions outside of the mask.</returns>
+	bool get(int x, int y) const
+	{
+		if (x < 0 || x >= _sizeX || y < 0 || y >= _sizeY)
+			return false;
+		return (row(y)[x / wordBits] >> (x % wordBits)) & 1u;
+	}
+
+	/// <summary>
+	/// Sets the value of a position.
+	/// </summary>
+	void set(int x, int y, bool value = true)
+	{
+		if (x < 0 || x >= _sizeX || y < 0 || y >= _sizeY)
+			throw std::out_of_range("The position is outside of the mask.");
+		WordType bit = WordType(1) << (x % wordBits);
+		if (value)
+			row(y)[x / wordBits] |= bit;
+		else
+			row(y)[x / wordBits] &= ~bit;
+	}
+
+	/// <summary>
+	/// Sets the value of all positions.
+	/// </summary>
+	void fill(bool value)
+	{
+		std::fill(_words.begin(), _words.end(), value ? ~WordType(0) : WordType(0));
+		if (value)
+			clearPadding();
+	}
+
+	/// <summary>
+	/// Counts the set positions.
+	/// </summary>
+	std::size_t count() const
+	{
+		std::size_t result = 0;
+		for (WordType word : _words)
+			result += popCount(word);
+		return result;
+	}
+
+	BitMask& operator&=(const BitMask& other) { return combine(other, [](WordType a, WordType b) { return a & b; }); }
+	BitMask& operator|=(const BitMask& other) { return combine(other, [](WordType a, WordType b) { return a | b; }); }
+	BitMask& operator^=(const BitMask& other) { return combine(other, [](WordType a, WordType b) { return a ^ b; }); }
+
+	bool operator==(const BitMask& other) const
+	{
+		return _sizeX == other._sizeX && _sizeY == other._sizeY && _words == other._words;
+	}
+	bool operator!=(const BitMask& other) const { return !(*this == other); }
+
+	/// <summary>
+	/// Computes the morphological dilation of the mask with a 3x3 structuring element.
+	/// </summary>
+	/// <param name="diagonal"><c>true</c> for the full 3x3 square, <c>false</c> for the 4-connected cross.</param>
+	BitMask dilate(bool diagonal = true) const;
+
+	/// <summary>
+	/// Computes the morphological erosion of the mask with a 3x3 structuring element.
+	/// </summary>
+	/// <param name="diagonal"><c>true</c> for the full 3x3 square, <c>false</c> for the 4-connected cross.</param>
+	BitMask erode(bool diagonal = true) const;
+
+	/// <summary>
+	/// Selects the positions with at least the given number of set neighbors.
+	/// </summary>
+	/// <remarks>
+	/// The neighbors are counted in bit-sliced counters, so no per position arithmetic is performed.
+	/// The position itself is not counted.
+	/// </remarks>
+	/// <param name="threshold">The minimal number of set neighbors.</param>
+	/// <param name="diagonal"><c>true</c> for the 8 surrounding neighbors, <c>false</c> for the 4 edge neighbors.</param>
+	BitMask neighborCount(int threshold, bool diagonal = true) const;
+
+private:
+	static int popCount(WordType word)
+	{
+		word = word - ((word >> 1) & 0x5555555555555555ull);
+		word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+		word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+	}
+
+	/// <summary>
+	/// Unsets the bits beyond the width of the mask.
+	/// </summary>
+	void clearPadding()
+	{
+		if (_sizeX % wordBits == 0)
+			return;
+		WordType last = (WordType(1) << (_sizeX % wordBits)) - 1;
+		for (int y = 0; y < _sizeY; ++y)
+			row(y)[_stride - 1] &= last;
+	}
+
+	template <typename Operator>
+	BitMask& combine(const BitMask& other, Operator op)
+	{
+		if (_sizeX != other._sizeX || _sizeY != other._sizeY)
+			throw std::invalid_argument("The size of the masks must match.");
+		for (std::size_t i = 0; i < _words.size(); ++i)
+			_words[i] = op(_words[i], other._words[i]);
+		return *this;
+	}
+
+	/// <summary>
+	/// Retrieves a word of a row shifted to the left neighbors of the positions, i.e. bit <c>x</c> holds column <c>x - 1</c>.
+	/// </summary>
+	WordType west(const WordType* words, int k) const
+	{
+		return (words[k] << 1) | (k > 0 ? words[k - 1] >> (wordBits - 1) : 0);
+	}
+
+	/// <summary>
+	/// Retrieves a word of a row shifted to the right neighbors of the positions, i.e. bit <c>x</c> holds column <c>x + 1</c>.
+	/// </summary>
+	WordType east(const WordType* words, int k) const
+	{
+		return (words[k] >> 1) | (k < _stride - 1 ? words[k + 1] << (wordBits - 1) : 0);
+	}
+};
+
+inline BitMask BitMask::dilate(bool diagonal) const
+{
+	BitMask result(_sizeX, _sizeY);
+	std::vector<WordType> vertical(_stride);
+	for (int y = 0; y < _sizeY; ++y)
+	{
+		const WordType* center = row(y);
+		const WordType* above = y > 0 ? row(y - 1) : nullptr;
+		const WordType* below = y < _sizeY - 1 ? row(y + 1) : nullptr;
+		WordType* target = result.row(y);
+
+		for (int k = 0; k < _stride; ++k)
+			vertical[k] = center[k] | (above ? above[k] : 0) | (below ? below[k] : 0);
+
+		const WordType* horizontal = diagonal ? vertical.data() : center;
+		for (int k = 0; k < _stride; ++k)
+			target[k] = vertical[k] | west(horizontal, k) | east(horizontal, k);
+	}
+	result.clearPadding();
+	return result;
+}
+
+inline BitMask BitMask::erode(bool diagonal) const
+{
+	BitMask result(_sizeX, _sizeY);
+	if (_sizeY < 3)
+		return result;
+
+	std::vector<WordType> vertical(_stride);
+	for (int y = 1; y < _sizeY - 1; ++y)
+	{
+		const WordType* center = row(y);
+		const WordType* above = row(y - 1);
+		const WordType* below = row(y + 1);
+		WordType* target = result.row(y);
+
+		for (int k = 0; k < _stride; ++k)
+			vertical[k] = center[k] & above[k] & below[k];
+
+		const WordType* horizontal = diagonal ? vertical.data() : center;
+		// The unset bits shifted in at the edges erode the first and the last column
+		for (int k = 0; k < _stride; ++k)
+			target[k] = vertical[k] & west(horizontal, k) & east(horizontal, k);
+	}
+	result.clearPadding();
+	return result;
+}
+
+inline BitMask BitMask::neighborCount(int threshold, bool diagonal) const
+{
+	if (threshold <= 0)
+		return BitMask(_sizeX, _sizeY, true);
+
+	BitMask result(_sizeX, _sizeY);
+	WordType counters[4];
+	auto add = [&counters](WordType word)
+	{
+		for (WordType& counter : counters)
+		{
+			WordType carry = counter & word;
+			counter ^= word;
+			word = carry;
+		}
+	};
+
+	for (int y = 0; y < _sizeY; ++y)
+	{
+		const WordType* center = row(y);
+		const WordType* above = y > 0 ? row(y - 1) : nullptr;
+		const WordType* below = y < _sizeY - 1 ? row(y + 1) : nullptr;
+		WordType* target = result.row(y);
+
+		for (int k = 0; k < _stride; ++k)
+		{
+			std::fill(counters, counters + 4, WordType(0));
+			add(west(center, k));
+			add(east(center, k));
+			if (above)
+			{
+				add(above[k]);
+				if (diagonal)
+				{
+					add(west(above, k));
+					add(east(above, k));
+				}
+			}
+			if (below)
+			{
+				add(below[k]);
+				if (diagonal)
+				{
+					add(west(below, k));
+					add(east(below, k));
+				}
+			}
+
+			// Bitwise comparison of the counters with the threshold from the most significant bit
+			WordType greater = 0, equal = ~WordType(0);
+			for (int b = 3; b >= 0; --b)
+			{
+				if ((threshold >> b) & 1)
+					equal &= counters[b];
+				else
+				{
+					greater |= equal & counters[b];
+					equal &= ~counters[b];
+				}
+			}
+			target[k] = threshold > 15 ? 0 : greater | equal;
+		}
+	}
+	result.clearPadding();
+	return result;
+}
+} // DEM
+} // CloudTools
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include "Helper.h"
+#include "ValidityMask.hpp"
+#include "Quantization.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a buffer for a rectangular block of a raster band.
+/// </summary>
+/// <remarks>
+/// The buffer is allocated once for the maximal block size and reused for each fetched block,
+/// so the memory consumption is independent of the raster size.
+/// The validity of each row is packed into bits when read, combining the nodata value
+/// and the mask band of the raster band if it has one. The masked out positions contain the nodata value.
+/// </remarks>
+template <typename DataType>
+class BlockBuffer
+{
+private:
+	GDALRasterBand* _band;
+	GDALRasterBand* _maskBand;
+	std::mutex* _bandMutex;
+	Quantization _quantization;
+	DataType _nodataValue;
+	int _capacityX;
+	int _capacityY;
+	int _words;
+
+	std::vector<DataType> _buffer;
+	std::vector<const DataType*> _rows;
+	std::vector<std::uint64_t> _bits;
+	std::vector<const std::uint64_t*> _validity;
+	std::vector<GByte> _mask;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="band">The raster band to read the blocks from.</param>
+	/// <param name="capacityX">The maximal width of a block.</param>
+	/// <param name="capacityY">The maximal height of a block.</param>
+	/// <param name="bandMutex">The mutex guarding the band when shared between threads.</param>
+	BlockBuffer(GDALRasterBand* band, int capacityX, int capacityY, std::mutex* bandMutex = nullptr)
+		: _band(band), _maskBand(validityMaskBand(band)), _bandMutex(bandMutex),
+		  _quantization(Quantization::of(band)),
+		  _nodataValue(static_cast<DataType>(Quantization::nodataValue(band))),
+		  _capacityX(capacityX), _capacityY(capacityY), _words(validityWords(capacityX)),
+		  _buffer(static_cast<std::size_t>(capacityX) * capacityY),
+		  _bits(static_cast<std::size_t>(_words) * capacityY)
+	{
+		if (_capacityX < 1 || _capacityY < 1)
+			throw std::invalid_argument("The capacity of the buffer must be positive.");
+		if (_maskBand != nullptr)
+			_mask.resize(_buffer.size());
+		_rows.reserve(_capacityY);
+		_validity.reserve(_capacityY);
+	}
+
+	BlockBuffer(const BlockBuffer&) = delete;
+	BlockBuffer& operator=(const BlockBuffer&) = delete;
+
+	/// <summary>
+	/// Gets the nodata value of the band.
+	/// </summary>
+	DataType nodataValue() const { return _nodataValue; }
+
+	/// <summary>
+	/// Retrieves the row pointers of the fetched block in order.
+	/// </summary>
+	const DataType* const* rows() const { return _rows.data(); }
+
+	/// <summary>
+	/// Retrieves the packed validity bits of the rows of the fetched block in order.
+	/// </summary>
+	const std::uint64_t* const* validity() const { return _validity.data(); }
+
+	/// <summary>
+	/// Reads the given block of the band into the buffer.
+	/// </summary>
+	/// <param name="offsetX">The abcissa offset of the block.</param>
+	/// <param name="offsetY">The ordinate offset of the block.</param>
+	/// <param name="sizeX">The width of the block.</param>
+	/// <param name="sizeY">The height of the block.</param>
+	/// <returns>The result of the raster I/O operation.</returns>
+	CPLErr fetch(int offsetX, int offsetY, int sizeX, int sizeY)
+	{
+		if (sizeX < 0 || sizeX > _capacityX || sizeY < 0 || sizeY > _capacityY)
+			throw std::out_of_range("The requested block exceeds the capacity of the buffer.");
+
+		_rows.clear();
+		_validity.clear();
+		for (int j = 0; j < sizeY; ++j)
+		{
+			_rows.push_back(&_buffer[static_cast<std::size_t>(j) * sizeX]);
+			_validity.push_back(&_bits[static_cast<std::size_t>(j) * _words]);
+		}
+		if (sizeX == 0 || sizeY == 0)
+			return CE_None;
+
+		CPLErr ioResult;
+		{
+			std::unique_lock<std::mutex> lock;
+			if (_bandMutex != nullptr)
+				lock = std::unique_lock<std::mutex>(*_bandMutex);
+
+			ioResult = _band->RasterIO(GF_Read,
+				offsetX, offsetY,
+				sizeX, sizeY,
+				&_buffer[0], sizeX, sizeY,
+				gdalType<DataType>(), 0, 0);
+			if (_maskBand != nullptr)
+				ioResult = static_cast<CPLErr>(ioResult | _maskBand->RasterIO(GF_Read,
+					offsetX, offsetY,
+					sizeX, sizeY,
+					&_mask[0], sizeX, sizeY,
+					GDT_Byte, 0, 0));
+		}
+		_quantization.dequantize(&_buffer[0], static_cast<std::size_t>(sizeX) * sizeY);
+		applyMask(&_buffer[0], _maskBand != nullptr ? &_mask[0] : nullptr, static_cast<std::size_t>(sizeX) * sizeY, _nodataValue);
+
+		for (int j = 0; j < sizeY; ++j)
+			packValidity<DataType>(_rows[j],
+				_maskBand != nullptr ? &_mask[static_cast<std::size_t>(j) * sizeX] : nullptr,
+				sizeX, _nodataValue, &_bits[static_cast<std::size_t>(j) * _words]);
+		return ioResult;
+	}
+};
+} // DEM
+} // CloudTools
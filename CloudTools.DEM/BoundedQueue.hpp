@@ -0,0 +1,90 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a thread-safe, blocking FIFO queue with limited capacity.
+/// </summary>
+template <typename ValueType>
+class BoundedQueue
+{
+private:
+	std::deque<ValueType> _items;
+	std::size_t _capacity;
+	bool _closed;
+
+	std::mutex _mutex;
+	std::condition_variable _notFull;
+	std::condition_variable _notEmpty;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="capacity">The maximal number of items in the queue.</param>
+	explicit BoundedQueue(std::size_t capacity)
+		: _capacity(capacity), _closed(false)
+	{
+		if (_capacity < 1)
+			throw std::invalid_argument("The capacity of the queue must be positive.");
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	/// <summary>
+	/// Appends an item to the queue, waits while the queue is full.
+	/// </summary>
+	/// <returns><c>false</c> if the queue was closed, otherwise <c>true</c>.</returns>
+	bool push(const ValueType& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notFull.wait(lock, [this] { return _closed || _items.size() < _capacity; });
+		if (_closed)
+			return false;
+
+		_items.push_back(item);
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	/// <summary>
+	/// Removes the first item of the queue, waits while the queue is empty.
+	/// </summary>
+	/// <remarks>
+	/// The remaining items of a closed queue are still retrieved.
+	/// </remarks>
+	/// <returns><c>false</c> if the queue is closed and empty, otherwise <c>true</c>.</returns>
+	bool pop(ValueType& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notEmpty.wait(lock, [this] { return _closed || !_items.empty(); });
+		if (_items.empty())
+			return false;
+
+		item = _items.front();
+		_items.pop_front();
+		_notFull.notify_one();
+		return true;
+	}
+
+	/// <summary>
+	/// Closes the queue: no further items are accepted and the waiting threads are released.
+	/// </summary>
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closed = true;
+		_notFull.notify_all();
+		_notEmpty.notify_all();
+	}
+};
+} // DEM
+} // CloudTools
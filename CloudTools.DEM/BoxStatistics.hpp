@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include "RowWindow.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Computes the sums and the numbers of the valid data in the <c>(2 * range + 1)^2</c> sized box windows of a target row.
+/// </summary>
+/// <remarks>
+/// The box sums are slid horizontally over the column sums of the window, so the cost per position is
+/// independent of the range when the column sums are maintained by the row window cache
+/// (see <see cref="RowWindowCache::setColumnStatistics"/>). Otherwise the column sums are computed from the scanlines.
+/// </remarks>
+/// <param name="window">The row window of the source.</param>
+/// <param name="sums">The sums of the valid data for the positions of the row (<c>sizeX</c> elements).</param>
+/// <param name="counts">The numbers of the valid data for the positions of the row (<c>sizeX</c> elements).</param>
+template <typename DataType>
+void boxStatistics(const RowWindow<DataType>& window, double* sums, int* counts)
+{
+	const int sizeX = window.sizeX();
+	const int range = window.range();
+	if (sizeX <= 0)
+		return;
+
+	const double* columnSums = window.columnSums();
+	const int* columnCounts = window.columnCounts();
+	std::vector<double> computedSums;
+	std::vector<int> computedCounts;
+	if (columnSums == nullptr || columnCounts == nullptr)
+	{
+		computedSums.assign(sizeX + 2 * range, 0.0);
+		computedCounts.assign(sizeX + 2 * range, 0);
+		for (int j = -range; j <= range; ++j)
+		{
+			const DataType* data = window.data(j) - range;
+			const GByte* valid = window.valid(j) - range;
+			for (int k = 0; k < sizeX + 2 * range; ++k)
+			{
+				computedSums[k] += valid[k] ? static_cast<double>(data[k]) : 0.0;
+				computedCounts[k] += valid[k];
+			}
+		}
+		columnSums = &computedSums[range];
+		columnCounts = &computedCounts[range];
+	}
+
+	// Slide the box along the row
+	double sum = 0;
+	int count = 0;
+	for (int i = -range; i <= range; ++i)
+	{
+		sum += columnSums[i];
+		count += columnCounts[i];
+	}
+	sums[0] = sum;
+	counts[0] = count;
+	for (int x = 1; x < sizeX; ++x)
+	{
+		sum += columnSums[x + range] - columnSums[x - range - 1];
+		count += columnCounts[x + range] - columnCounts[x - range - 1];
+		if (count == 0)
+			sum = 0;
+		sums[x] = sum;
+		counts[x] = count;
+	}
+}
+} // DEM
+} // CloudTools
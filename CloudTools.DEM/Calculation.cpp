@@ -84,6 +84,19 @@ const RasterMetadata& Calculation::targetMetadata() const
 	return _targetMetadata;
 }
 
+GDALDataset* Calculation::openSourceHandle(unsigned int index) const
+{
+	GDALDataset* dataset = _sourceDatasets.at(index);
+	GDALDriver* driver = dataset->GetDriver();
+	if (driver != nullptr && std::string(driver->GetDescription()) == "MEM")
+		return nullptr;
+
+	std::string path = _sourceOwnership ? _sourcePaths[index] : std::string(dataset->GetDescription());
+	if (path.empty())
+		return nullptr;
+	return static_cast<GDALDataset*>(GDALOpen(path.c_str(), GA_ReadOnly));
+}
+
 void Calculation::onPrepare()
 {
 	// Verify matching pixel sizes
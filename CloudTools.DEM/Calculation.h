@@ -80,6 +80,16 @@ protected:
 	/// Verifies sources and calculates the metadata for the target.
 	/// </summary>
 	void onPrepare() override;
+
+	/// <summary>
+	/// Opens a separate read-only handle for a source dataset, e.g. for reading it on another thread.
+	/// </summary>
+	/// <remarks>
+	/// The returned handle is owned by the caller and must be closed by <c>GDALClose</c>.
+	/// </remarks>
+	/// <param name="index">The index of the source.</param>
+	/// <returns>The new dataset handle; or <c>nullptr</c> if the source cannot be reopened (e.g. in-memory datasets).</returns>
+	GDALDataset* openSourceHandle(unsigned int index) const;
 };
 } // DEM
 } // CloudTools
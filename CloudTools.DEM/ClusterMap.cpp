@@ -1,5 +1,4 @@
 #include <algorithm>
-#include <numeric>
 #include <unordered_set>
 #include <stdexcept>
 
@@ -12,11 +11,13 @@ namespace DEM
 void ClusterMap::setSizeX(int x)
 {
 	_sizeX = x;
+	relabel();
 }
 
 void ClusterMap::setSizeY(int y)
 {
 	_sizeY = y;
+	relabel();
 }
 
 int ClusterMap::sizeX()
@@ -31,7 +32,10 @@ int ClusterMap::sizeY()
 
 GUInt32 ClusterMap::clusterIndex(int x, int y) const
 {
-	return _clusterPoints.at(OGRPoint(x, y));
+	GUInt32 label = _labels[position(x, y)];
+	if (label == 0)
+		throw std::out_of_range("Point is out of range.");
+	return find(label);
 }
 
 std::vector<GUInt32> ClusterMap::clusterIndexes() const
@@ -48,23 +52,16 @@ std::vector<GUInt32> ClusterMap::clusterIndexes() const
 
 void ClusterMap::addPoint(GUInt32 clusterIndex, int x, int y, double z)
 {
-	OGRPoint point(x, y, z);
-
 	if (_clusterIndexes.find(clusterIndex) == _clusterIndexes.end())
 		throw std::out_of_range("Cluster is out of range.");
 
-	if (std::find_if(_clusterIndexes[clusterIndex].begin(),
-	                 _clusterIndexes[clusterIndex].end(),
-	                 [&point](OGRPoint& p)
-	                 {
-		                 return point.getX() == p.getX() &&
-			                 point.getY() == p.getY();
-	                 })
-		!= _clusterIndexes[clusterIndex].end())
+	GUInt32& label = _labels[position(x, y)];
+	if (label != 0)
 		throw std::logic_error("Point is already in cluster.");
 
-	_clusterIndexes[clusterIndex].push_back(point);
-	_clusterPoints.insert(std::make_pair(point, clusterIndex));
+	_clusterIndexes[clusterIndex].emplace_back(x, y, static_cast<float>(z));
+	_statistics[clusterIndex].add(_clusterIndexes[clusterIndex].back());
+	label = clusterIndex;
 }
 
 void ClusterMap::removePoint(GUInt32 clusterIndex, int x, int y)
@@ -72,151 +69,112 @@ void ClusterMap::removePoint(GUInt32 clusterIndex, int x, int y)
 	if (_clusterIndexes.find(clusterIndex) == _clusterIndexes.end())
 		throw std::out_of_range("Cluster is out of range.");
 
-	OGRPoint point(x, y);
+	GUInt32& label = _labels[position(x, y)];
+	if (label == 0 || find(label) != clusterIndex)
+		throw std::out_of_range("Point is out of range.");
 
-	std::vector<OGRPoint>::iterator iter =
+	std::vector<ClusterPoint>::iterator iter =
 		std::find_if(_clusterIndexes[clusterIndex].begin(),
 		             _clusterIndexes[clusterIndex].end(),
-		             [&point](OGRPoint& p)
+		             [x, y](const ClusterPoint& p)
 		             {
-			             return point.getX() == p.getX() &&
-				             point.getY() == p.getY();
+			             return p.x == x && p.y == y;
 		             });
 
-	if (iter == _clusterIndexes[clusterIndex].end())
-		throw std::out_of_range("Point is out of range.");
-
+	_statistics[clusterIndex].remove(*iter);
 	_clusterIndexes[clusterIndex].erase(iter);
-	_clusterPoints.erase(point);
+	label = 0;
 
 	if (_clusterIndexes[clusterIndex].empty())
 		removeCluster(clusterIndex);
-	else if (_seedPoints[clusterIndex].getX() == point.getX() &&
-		_seedPoints[clusterIndex].getY() == point.getY())
+	else if (_seedPoints[clusterIndex].x == x &&
+		_seedPoints[clusterIndex].y == y)
 		_seedPoints.erase(clusterIndex);
 }
 
 std::vector<OGRPoint> ClusterMap::neighbors(GUInt32 clusterIndex) const
 {
-	std::unordered_set<OGRPoint, PointHash, PointEqual> neighbors;
-	for (const OGRPoint& p : points(clusterIndex))
+	std::unordered_set<std::size_t> visited;
+	std::vector<OGRPoint> neighbors;
+	for (const ClusterPoint& p : points(clusterIndex))
 	{
-		for (int i = p.getX() - 1; i <= p.getX() + 1; i++)
-			for (int j = p.getY() - 1; j <= p.getY() + 1; j++)
+		for (int i = p.x - 1; i <= p.x + 1; i++)
+			for (int j = p.y - 1; j <= p.y + 1; j++)
 				if (i >= 0 && i < _sizeX &&
 					j >= 0 && j < _sizeY &&
-					(i != p.getX() || j != p.getY()))
+					(i != p.x || j != p.y))
 				{
-					OGRPoint point(i, j, p.getZ());
-					if (_clusterPoints.find(point) == _clusterPoints.end())
-						neighbors.insert(point);
+					std::size_t index = position(i, j);
+					if (_labels[index] == 0 && visited.insert(index).second)
+						neighbors.emplace_back(i, j, p.z);
 				}
 	}
 
-	return std::vector<OGRPoint>(neighbors.begin(), neighbors.end());
+	return neighbors;
 }
 
 OGRPoint ClusterMap::center3D(GUInt32 clusterIndex) const
 {
-	auto clusterPoints = points(clusterIndex);
-	int avgX = std::accumulate(clusterPoints.begin(), clusterPoints.end(), 0,
-	                           [](int value, OGRPoint& p) { return value + p.getX(); }) / clusterPoints.size();
-	int avgY = std::accumulate(clusterPoints.begin(), clusterPoints.end(), 0,
-	                           [](int value, OGRPoint& p) { return value + p.getY(); }) / clusterPoints.size();
-	double avgZ = std::accumulate(clusterPoints.begin(), clusterPoints.end(), 0,
-	                              [](double value, OGRPoint& p) { return value + p.getZ(); }) / clusterPoints.size();
-	return OGRPoint(avgX, avgY, avgZ);
+	const Statistics& cluster = _statistics.at(clusterIndex);
+	long long size = static_cast<long long>(points(clusterIndex).size());
+	return OGRPoint(static_cast<int>(cluster.sumX / size),
+	                static_cast<int>(cluster.sumY / size),
+	                cluster.sumZ / size);
 }
 
 OGRPoint ClusterMap::center2D(GUInt32 clusterIndex) const
 {
-	auto clusterPoints = points(clusterIndex);
-	int avgX = std::accumulate(clusterPoints.begin(), clusterPoints.end(), 0,
-	                           [](int value, OGRPoint& p) { return value + p.getX(); }) / clusterPoints.size();
-	int avgY = std::accumulate(clusterPoints.begin(), clusterPoints.end(), 0,
-	                           [](int value, OGRPoint& p) { return value + p.getY(); }) / clusterPoints.size();
-
-	return OGRPoint(avgX, avgY);
+	const Statistics& cluster = _statistics.at(clusterIndex);
+	long long size = static_cast<long long>(points(clusterIndex).size());
+	return OGRPoint(static_cast<int>(cluster.sumX / size),
+	                static_cast<int>(cluster.sumY / size));
 }
 
 OGRPoint ClusterMap::highestPoint(GUInt32 clusterIndex) const
 {
-	auto clusterPoints = points(clusterIndex);
-	OGRPoint highest = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getZ() > highest.getZ())
-			highest = p;
-
-	return highest;
+	return statistics(clusterIndex).highest.toPoint();
 }
 
 OGRPoint ClusterMap::lowestPoint(GUInt32 clusterIndex) const
 {
-	auto clusterPoints = points(clusterIndex);
-	OGRPoint lowest = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getZ() < lowest.getZ())
-			lowest = p;
-
-	return lowest;
+	return statistics(clusterIndex).lowest.toPoint();
 }
 
 std::vector<OGRPoint> ClusterMap::boundingBox(GUInt32 clusterIndex) const
 {
-	std::vector<OGRPoint> borders;
-
-	auto clusterPoints = points(clusterIndex);
-	OGRPoint upperRight = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getX() > upperRight.getX() && p.getY() > upperRight.getY())
-			upperRight = p;
-
-	borders.push_back(upperRight);
-
-	OGRPoint lowerRight = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getX() < lowerRight.getX() && p.getY() > lowerRight.getY())
-			lowerRight = p;
-
-	borders.push_back(lowerRight);
-
-	OGRPoint lowerLeft = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getX() < lowerLeft.getX() && p.getY() < lowerLeft.getY())
-			lowerLeft = p;
-
-	borders.push_back(lowerLeft);
-
-	OGRPoint upperLeft = clusterPoints.at(0);
-	for (const auto& p : clusterPoints)
-		if (p.getX() > upperLeft.getX() && p.getY() < upperLeft.getY())
-			upperLeft = p;
-
-	borders.push_back(upperLeft);
-
-	return borders;
+	const Statistics& cluster = statistics(clusterIndex);
+	return std::vector<OGRPoint>
+	{
+		OGRPoint(cluster.maxX, cluster.maxY), // upper right
+		OGRPoint(cluster.minX, cluster.maxY), // lower right
+		OGRPoint(cluster.minX, cluster.minY), // lower left
+		OGRPoint(cluster.maxX, cluster.minY)  // upper left
+	};
 }
 
 OGRPoint ClusterMap::seedPoint(GUInt32 clusterIndex) const
 {
-	return _seedPoints.at(clusterIndex);
+	return _seedPoints.at(clusterIndex).toPoint();
 }
 
-const std::vector<OGRPoint>& ClusterMap::points(GUInt32 clusterIndex) const
+const std::vector<ClusterPoint>& ClusterMap::points(GUInt32 clusterIndex) const
 {
 	return _clusterIndexes.at(clusterIndex);
 }
 
 GUInt32 ClusterMap::createCluster(int x, int y, double z)
 {
-	OGRPoint point(x, y, z);
+	ClusterPoint point(x, y, static_cast<float>(z));
 
-	if (_clusterPoints.find(point) != _clusterPoints.end())
+	GUInt32& label = _labels[position(x, y)];
+	if (label != 0)
 		throw std::logic_error("Point already in cluster map.");
 
 	_clusterIndexes[_nextClusterIndex].push_back(point);
-	_clusterPoints[point] = _nextClusterIndex;
+	_statistics[_nextClusterIndex] = Statistics(point);
 	_seedPoints[_nextClusterIndex] = point;
+	_parents.push_back(_nextClusterIndex);
+	label = _nextClusterIndex;
 	return _nextClusterIndex++;
 }
 
@@ -238,9 +196,8 @@ void ClusterMap::mergeClusters(GUInt32 clusterA, GUInt32 clusterB)
 		toCluster = clusterB;
 	}
 
-	// Update point to cluster map
-	for (const auto& point : _clusterIndexes[fromCluster])
-		_clusterPoints[point] = toCluster;
+	// Link the roots, the labels of the points are resolved by the lookups
+	_parents[fromCluster] = toCluster;
 
 	// Update cluster to points map
 	_clusterIndexes[toCluster].insert(
@@ -248,8 +205,11 @@ void ClusterMap::mergeClusters(GUInt32 clusterA, GUInt32 clusterB)
 		std::make_move_iterator(_clusterIndexes[fromCluster].begin()),
 		std::make_move_iterator(_clusterIndexes[fromCluster].end()));
 
+	_statistics[toCluster].merge(_statistics[fromCluster]);
+
 	// Remove merged cluster
 	_clusterIndexes.erase(fromCluster);
+	_statistics.erase(fromCluster);
 	_seedPoints.erase(fromCluster);
 }
 
@@ -259,8 +219,9 @@ void ClusterMap::removeCluster(GUInt32 clusterIndex)
 		throw std::out_of_range("The specified cluster does not exist.");
 
 	for (const auto& point : _clusterIndexes[clusterIndex])
-		_clusterPoints.erase(point);
+		_labels[position(point.x, point.y)] = 0;
 	_clusterIndexes.erase(clusterIndex);
+	_statistics.erase(clusterIndex);
 	_seedPoints.erase(clusterIndex);
 }
 
@@ -286,7 +247,125 @@ void ClusterMap::shuffle()
 	for (auto& item : _clusterIndexes)
 	{
 		std::shuffle(item.second.begin(), item.second.end(), engine);
+		// The first of the tied extremal points may change
+		_statistics[item.first].extremaValid = false;
+	}
+}
+
+std::size_t ClusterMap::position(int x, int y) const
+{
+	if (x < 0 || x >= _sizeX || y < 0 || y >= _sizeY)
+		throw std::out_of_range("Point is out of range.");
+	return static_cast<std::size_t>(y) * _sizeX + x;
+}
+
+GUInt32 ClusterMap::find(GUInt32 label) const
+{
+	GUInt32 root = label;
+	while (_parents[root] != root)
+		root = _parents[root];
+
+	while (_parents[label] != root)
+	{
+		GUInt32 next = _parents[label];
+		_parents[label] = root;
+		label = next;
+	}
+	return root;
+}
+
+void ClusterMap::relabel()
+{
+	_labels.assign(static_cast<std::size_t>(std::max(_sizeX, 0)) * std::max(_sizeY, 0), 0);
+	for (const auto& item : _clusterIndexes)
+		for (const auto& point : item.second)
+			_labels[position(point.x, point.y)] = item.first;
+}
+
+const ClusterMap::Statistics& ClusterMap::statistics(GUInt32 clusterIndex) const
+{
+	Statistics& cluster = _statistics.at(clusterIndex);
+	if (!cluster.extremaValid)
+		cluster.rescan(points(clusterIndex));
+	return cluster;
+}
+
+ClusterMap::Statistics::Statistics(const ClusterPoint& point)
+	: sumX(point.x), sumY(point.y), sumZ(point.z),
+	  highest(point), lowest(point),
+	  minX(point.x), maxX(point.x), minY(point.y), maxY(point.y),
+	  extremaValid(true)
+{ }
+
+void ClusterMap::Statistics::add(const ClusterPoint& point)
+{
+	sumX += point.x;
+	sumY += point.y;
+	sumZ += point.z;
+
+	if (!extremaValid)
+		return;
+	if (point.z > highest.z)
+		highest = point;
+	if (point.z < lowest.z)
+		lowest = point;
+	minX = std::min(minX, point.x);
+	maxX = std::max(maxX, point.x);
+	minY = std::min(minY, point.y);
+	maxY = std::max(maxY, point.y);
+}
+
+void ClusterMap::Statistics::remove(const ClusterPoint& point)
+{
+	sumX -= point.x;
+	sumY -= point.y;
+	sumZ -= point.z;
+
+	if (point.x == minX || point.x == maxX || point.y == minY || point.y == maxY ||
+		(point.x == highest.x && point.y == highest.y) ||
+		(point.x == lowest.x && point.y == lowest.y))
+		extremaValid = false;
+}
+
+void ClusterMap::Statistics::merge(const Statistics& other)
+{
+	sumX += other.sumX;
+	sumY += other.sumY;
+	sumZ += other.sumZ;
+
+	if (!extremaValid || !other.extremaValid)
+	{
+		extremaValid = false;
+		return;
+	}
+	if (other.highest.z > highest.z)
+		highest = other.highest;
+	if (other.lowest.z < lowest.z)
+		lowest = other.lowest;
+	minX = std::min(minX, other.minX);
+	maxX = std::max(maxX, other.maxX);
+	minY = std::min(minY, other.minY);
+	maxY = std::max(maxY, other.maxY);
+}
+
+void ClusterMap::Statistics::rescan(const std::vector<ClusterPoint>& points)
+{
+	const ClusterPoint& first = points.at(0);
+	highest = lowest = first;
+	minX = maxX = first.x;
+	minY = maxY = first.y;
+	for (const ClusterPoint& point : points)
+	{
+		if (point.z > highest.z)
+			highest = point;
+		if (point.z < lowest.z)
+			lowest = point;
+		minX = std::min(minX, point.x);
+		maxX = std::max(maxX, point.x);
+		minY = std::min(minY, point.y);
+		maxY = std::max(maxY, point.y);
 	}
+	extremaValid = true;
 }
 
 std::random_device ClusterMap::rd;
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <map>
+#include <cmath>
 #include <unordered_map>
 #include <random>
 
@@ -16,17 +17,89 @@ namespace CloudTools
 {
 namespace DEM
 {
+/// <summary>
+/// Represents a grid point of a cluster.
+/// </summary>
+/// <remarks>
+/// The point is stored in 12 bytes, while the accessors mirror <c>OGRPoint</c>.
+/// </remarks>
+struct ClusterPoint
+{
+	GInt32 x;
+	GInt32 y;
+	float z;
+
+	ClusterPoint() = default;
+
+	ClusterPoint(GInt32 x, GInt32 y, float z = 0.f)
+		: x(x), y(y), z(z)
+	{ }
+
+	GInt32 getX() const { return x; }
+	GInt32 getY() const { return y; }
+	float getZ() const { return z; }
+
+	/// <summary>
+	/// Calculates the horizontal distance to an other point.
+	/// </summary>
+	double distance(const ClusterPoint& other) const
+	{
+		return std::sqrt(std::pow(double(x) - other.x, 2.0) + std::pow(double(y) - other.y, 2.0));
+	}
+
+	/// <summary>
+	/// Creates an <c>OGRPoint</c> of the point.
+	/// </summary>
+	OGRPoint toPoint() const
+	{
+		return OGRPoint(x, y, z);
+	}
+};
+
 /// <summary>
 /// Represents a cluster map of a DEM dataset.
 /// </summary>
+/// <remarks>
+/// The clusters are stored in a dense label raster of <c>sizeX * sizeY</c> positions and a union-find forest over the labels.
+/// A position holds the label it was added with (0 if it is not clustered), while merging only links the root of the
+/// smaller cluster to the root of the larger one, so the labels of the merged points are never rewritten.
+/// The index of a cluster is the label of its root. The lookups compress the paths of the forest,
+/// therefore concurrent lookups on the same instance are not safe.
+///
+/// The coordinate sums, the extremal points and the bounding box of the clusters are maintained on every modification,
+/// so the centers, extrema and bounding boxes are retrieved in constant time. Removing an extremal point defers
+/// the rescan of the extrema of its cluster until they are next queried.
+/// </remarks>
 class ClusterMap
 {
 private:
-	std::map<GUInt32, OGRPoint> _seedPoints;
-	std::map<GUInt32, std::vector<OGRPoint>> _clusterIndexes;
-	std::unordered_map<OGRPoint, GUInt32, PointHash, PointEqual> _clusterPoints;
+	/// <summary>
+	/// Represents the running statistics of a cluster.
+	/// </summary>
+	struct Statistics
+	{
+		long long sumX = 0, sumY = 0;
+		double sumZ = 0;
+		ClusterPoint highest, lowest;
+		GInt32 minX = 0, maxX = 0, minY = 0, maxY = 0;
+		bool extremaValid = false;
+
+		Statistics() = default;
+		explicit Statistics(const ClusterPoint& point);
+
+		void add(const ClusterPoint& point);
+		void remove(const ClusterPoint& point);
+		void merge(const Statistics& other);
+		void rescan(const std::vector<ClusterPoint>& points);
+	};
+
+	std::map<GUInt32, ClusterPoint> _seedPoints;
+	std::map<GUInt32, std::vector<ClusterPoint>> _clusterIndexes;
+	mutable std::map<GUInt32, Statistics> _statistics;
+	std::vector<GUInt32> _labels;
+	mutable std::vector<GUInt32> _parents = { 0 };
 	GUInt32 _nextClusterIndex = 1;
-	int _sizeX, _sizeY;
+	int _sizeX = 0, _sizeY = 0;
 
 public:
 	/// <summary>
@@ -41,10 +114,23 @@ public:
 	/// <param name="sizeY">The width of the cluster map.</param>
 	ClusterMap(int sizeX, int sizeY) : _sizeX(sizeX), _sizeY(sizeY)
 	{
+		relabel();
 	}
 
+	/// <summary>
+	/// Sets the width of the cluster map.
+	/// </summary>
+	/// <remarks>
+	/// The label raster is rebuilt from the clustered points, which must fit in the new size.
+	/// </remarks>
 	void setSizeX(int x);
 
+	/// <summary>
+	/// Sets the height of the cluster map.
+	/// </summary>
+	/// <remarks>
+	/// The label raster is rebuilt from the clustered points, which must fit in the new size.
+	/// </remarks>
 	void setSizeY(int y);
 
 	int sizeX();
@@ -57,6 +143,7 @@ public:
 	/// <param name="x">The abcissa of the point.</param>
 	/// <param name="y">The ordinate of the point.</param>
 	/// <returns>The cluster index for the point.</returns>
+	/// <exception cref="std::out_of_range">The point is not clustered or is outside of the cluster map.</exception>
 	GUInt32 clusterIndex(int x, int y) const;
 
 	/// <summary>
@@ -139,7 +226,7 @@ public:
 	/// </summary>
 	/// <param name="clusterIndex">The index of the cluster.</param>
 	/// <returns>The points contained by the cluster.</returns>
-	const std::vector<OGRPoint>& points(GUInt32 clusterIndex) const;
+	const std::vector<ClusterPoint>& points(GUInt32 clusterIndex) const;
 
 	/// <summary>
 	/// Creates a new cluster with an initial point.
@@ -179,6 +266,27 @@ public:
 	void shuffle();
 
 private:
+	/// <summary>
+	/// Retrieves the position of a grid point in the label raster.
+	/// </summary>
+	/// <exception cref="std::out_of_range">The point is outside of the cluster map.</exception>
+	std::size_t position(int x, int y) const;
+
+	/// <summary>
+	/// Retrieves the root of a label in the union-find forest and compresses the path to it.
+	/// </summary>
+	GUInt32 find(GUInt32 label) const;
+
+	/// <summary>
+	/// Rebuilds the label raster from the clustered points.
+	/// </summary>
+	void relabel();
+
+	/// <summary>
+	/// Retrieves the statistics of a cluster, rescanning its extrema if they were invalidated.
+	/// </summary>
+	const Statistics& statistics(GUInt32 clusterIndex) const;
+
 	static std::random_device rd;
 	static std::mt19937 engine;
 };
@@ -2,20 +2,40 @@
 
 #include <string>
 #include <vector>
-#include <cmath>
 
 #include "../SweepLineTransformation.hpp"
 #include "../Window.hpp"
+#include "../RowWindow.hpp"
+#include "../Elementwise.hpp"
 
 namespace CloudTools
 {
 namespace DEM
 {
+/// <summary>
+/// Represents the data type of the differences of a source data type.
+/// </summary>
+/// <remarks>
+/// The differences of unsigned sources are computed in a signed type, so negative changes are preserved.
+/// </remarks>
+template <typename SourceType>
+struct DifferenceType
+{
+	typedef SourceType type;
+};
+
+template <> struct DifferenceType<GByte> { typedef GInt16 type; };
+template <> struct DifferenceType<GUInt16> { typedef GInt32 type; };
+template <> struct DifferenceType<GUInt32> { typedef double type; };
+
 /// <summary>
 /// Represents a difference comparison for DEM datasets.
 /// </summary>
-template <typename DataType = float>
-class Difference : public SweepLineTransformation<DataType>
+/// <remarks>
+/// The differences are computed row by row with the elementwise kernels, without constructing windows.
+/// </remarks>
+template <typename DataType = float, typename TargetType = typename DifferenceType<DataType>::type>
+class Difference : public SweepLineTransformation<TargetType, DataType>
 {
 public:	
 	double maximumThreshold = 1000;
@@ -31,7 +51,7 @@ public:
 	Difference(const std::vector<std::string>& sourcePaths,
 	           const std::string& targetPath,
 		       Operation::ProgressType progress = nullptr)
-		: SweepLineTransformation<DataType>(sourcePaths, targetPath, nullptr, progress)
+		: SweepLineTransformation<TargetType, DataType>(sourcePaths, targetPath, nullptr, progress)
 	{
 		initialize();
 	}
@@ -45,7 +65,7 @@ public:
 	Difference(const std::vector<GDALDataset*>& sourceDatasets,
 		       const std::string& targetPath,
 		       Operation::ProgressType progress = nullptr)
-		: SweepLineTransformation<DataType>(sourceDatasets, targetPath, 0, nullptr, progress)
+		: SweepLineTransformation<TargetType, DataType>(sourceDatasets, targetPath, 0, nullptr, progress)
 	{
 		initialize();
 	}
@@ -60,18 +80,22 @@ private:
 	void initialize();
 };
 
-template <typename DataType>
-void Difference<DataType>::initialize()
+template <typename DataType, typename TargetType>
+void Difference<DataType, TargetType>::initialize()
 {
-	this->computation = [this](int x, int y, const std::vector<Window<DataType>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<DataType>>& sources, TargetType* target)
 	{
-		if (!sources[0].hasData() || !sources[1].hasData())
-			return static_cast<DataType>(this->nodataValue);
+		const int sizeX = sources[0].sizeX();
+		const GByte* valid0 = sources[0].valid();
+		const GByte* valid1 = sources[1].valid();
+
+		std::vector<GByte> condition(sizeX);
+		for (int x = 0; x < sizeX; ++x)
+			condition[x] = valid0[x] & valid1[x];
 
-		DataType difference = sources[1].data() - sources[0].data();
-		if (std::abs(difference) >= this->maximumThreshold || std::abs(difference) <= this->minimumThreshold)
-			difference = static_cast<DataType>(this->nodataValue);
-		return difference;
+		thresholdedDifference(sources[1].data(), sources[0].data(), condition.data(), sizeX,
+			this->minimumThreshold, this->maximumThreshold,
+			static_cast<TargetType>(this->nodataValue), target);
 	};
 }
 } // DEM
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "UnionFind.hpp"
+#include "ParallelFor.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a parallel connected-component labeling of rasters.
+/// </summary>
+/// <remarks>
+/// The raster is split into blocks of full rows, which are labeled concurrently with a local union-find forest each.
+/// The equivalences of the labels across the block borders are then resolved in a global forest
+/// and the positions are relabeled concurrently.
+/// The components are numbered from 1 in row-major order of their first position, independently of the blocks.
+/// </remarks>
+class ComponentLabeling
+{
+public:
+	typedef UnionFind::LabelType LabelType;
+
+	enum class Connectivity
+	{
+		/// <summary>
+		/// The horizontal and vertical neighbors are considered.
+		/// </summary>
+		Four,
+		/// <summary>
+		/// The diagonal neighbors are also considered.
+		/// </summary>
+		Eight
+	};
+
+	/// <summary>
+	/// The neighborhood of the positions.
+	/// </summary>
+	Connectivity connectivity = Connectivity::Eight;
+
+	/// <summary>
+	/// The number of rows in a block.
+	/// </summary>
+	int blockSize = 256;
+
+	/// <summary>
+	/// The number of threads to label the blocks with.
+	/// </summary>
+	unsigned int threadCount = 1;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="connectivity">The neighborhood of the positions.</param>
+	/// <param name="threadCount">The number of threads to label the blocks with.</param>
+	ComponentLabeling(Connectivity connectivity = Connectivity::Eight, unsigned int threadCount = 1)
+		: connectivity(connectivity), threadCount(threadCount)
+	{ }
+
+	/// <summary>
+	/// Labels the connected components of a raster.
+	/// </summary>
+	/// <remarks>
+	/// The predicates are called concurrently from multiple threads, and must be symmetric.
+	/// The neighbor passed to <paramref name="connects"/> always precedes the position in row-major order.
+	/// </remarks>
+	/// <param name="sizeX">The width of the raster.</param>
+	/// <param name="sizeY">The height of the raster.</param>
+	/// <param name="valid">Determines whether a position <c>(x, y)</c> belongs to any component.</param>
+	/// <param name="connects">Determines whether a valid position <c>(x, y)</c> and its valid neighbor <c>(nx, ny)</c> may connect.</param>
+	/// <param name="labels">The labels of the positions in row-major order, 0 for the invalid ones.</param>
+	/// <returns>The number of components.</returns>
+	template <typename ValidPredicate, typename ConnectPredicate>
+	std::size_t label(int sizeX, int sizeY,
+	                  const ValidPredicate& valid, const ConnectPredicate& connects,
+	                  std::vector<LabelType>& labels) const;
+
+private:
+	/// <summary>
+	/// Labels the rows of a block with local labels numbered from 1 in row-major order of their first position.
+	/// </summary>
+	/// <returns>The number of local labels.</returns>
+	template <typename ValidPredicate, typename ConnectPredicate>
+	LabelType labelBlock(int sizeX, int firstRow, int lastRow,
+	                     const ValidPredicate& valid, const ConnectPredicate& connects,
+	                     LabelType* labels) const;
+};
+
+template <typename ValidPredicate, typename ConnectPredicate>
+std::size_t ComponentLabeling::label(int sizeX, int sizeY,
+                                     const ValidPredicate& valid, const ConnectPredicate& connects,
+                                     std::vector<LabelType>& labels) const
+{
+	if (sizeX < 0 || sizeY < 0)
+		throw std::invalid_argument("The size of the raster must be non-negative.");
+	if (blockSize < 1)
+		throw std::invalid_argument("The size of the blocks must be positive.");
+
+	labels.assign(static_cast<std::size_t>(sizeX) * sizeY, 0);
+	int blockCount = (sizeY + blockSize - 1) / blockSize;
+
+	// Label the blocks independently
+	std::vector<LabelType> localCounts(blockCount);
+	parallelFor(blockCount, threadCount, [&](int block)
+	{
+		int firstRow = block * blockSize;
+		localCounts[block] = labelBlock(sizeX, firstRow, std::min(firstRow + blockSize, sizeY),
+		                                valid, connects, labels.data() + static_cast<std::size_t>(firstRow) * sizeX);
+	});
+
+	// The global label of a local one is offset by the labels of the preceding blocks
+	std::vector<LabelType> offsets(blockCount + 1, 0);
+	for (int block = 0; block < blockCount; ++block)
+		offsets[block + 1] = offsets[block] + localCounts[block];
+
+	// Merge the labels across the block borders
+	UnionFind forest(offsets[blockCount] + 1);
+	for (int block = 1; block < blockCount; ++block)
+	{
+		int y = block * blockSize;
+		const LabelType* current = labels.data() + static_cast<std::size_t>(y) * sizeX;
+		const LabelType* above = current - sizeX;
+		for (int x = 0; x < sizeX; ++x)
+		{
+			if (!current[x])
+				continue;
+
+			LabelType label = offsets[block] + current[x];
+			for (int nx = x - 1; nx <= x + 1; ++nx)
+			{
+				if (nx < 0 || nx >= sizeX || !above[nx])
+					continue;
+				if (nx != x && connectivity == Connectivity::Four)
+					continue;
+				if (connects(x, y, nx, y - 1))
+					forest.unite(label, offsets[block - 1] + above[nx]);
+			}
+		}
+	}
+
+	// The roots are the smallest labels of the components, so numbering them in order preserves the order of appearance
+	std::vector<LabelType> resolved(forest.size(), 0);
+	LabelType componentCount = 0;
+	for (LabelType label = 1; label < forest.size(); ++label)
+	{
+		LabelType root = forest.find(label);
+		resolved[label] = root == label ? ++componentCount : resolved[root];
+	}
+
+	// Relabel the blocks
+	parallelFor(blockCount, threadCount, [&](int block)
+	{
+		std::size_t first = static_cast<std::size_t>(block) * blockSize * sizeX;
+		std::size_t last = static_cast<std::size_t>(std::min((block + 1) * blockSize, sizeY)) * sizeX;
+		for (std::size_t index = first; index < last; ++index)
+			if (labels[index])
+				labels[index] = resolved[offsets[block] + labels[index]];
+	});
+	return componentCount;
+}
+
+template <typename ValidPredicate, typename ConnectPredicate>
+ComponentLabeling::LabelType ComponentLabeling::labelBlock(int sizeX, int firstRow, int lastRow,
+                                                           const ValidPredicate& valid, const ConnectPredicate& connects,
+                                                           LabelType* labels) const
+{
+	UnionFind forest(1);
+	auto merge = [&forest](LabelType& label, LabelType neighbor)
+	{
+		label = label ? forest.unite(label, neighbor) : neighbor;
+	};
+
+	// First pass: provisional labels from the preceding neighbors in the block
+	for (int y = firstRow; y < lastRow; ++y)
+	{
+		LabelType* current = labels + static_cast<std::size_t>(y - firstRow) * sizeX;
+		LabelType* above = y > firstRow ? current - sizeX : nullptr;
+		for (int x = 0; x < sizeX; ++x)
+		{
+			if (!valid(x, y))
+				continue;
+
+			LabelType& label = current[x];
+			if (x > 0 && current[x - 1] && connects(x, y, x - 1, y))
+				label = current[x - 1];
+			if (above)
+			{
+				if (above[x] && connects(x, y, x, y - 1))
+					merge(label, above[x]);
+				if (connectivity == Connectivity::Eight)
+				{
+					if (x > 0 && above[x - 1] && connects(x, y, x - 1, y - 1))
+						merge(label, above[x - 1]);
+					if (x < sizeX - 1 && above[x + 1] && connects(x, y, x + 1, y - 1))
+						merge(label, above[x + 1]);
+				}
+			}
+			if (!label)
+				label = forest.add();
+		}
+	}
+
+	// Second pass: number the roots in the order of appearance
+	std::vector<LabelType> local(forest.size(), 0);
+	LabelType count = 0;
+	LabelType* end = labels + static_cast<std::size_t>(lastRow - firstRow) * sizeX;
+	for (LabelType* label = labels; label != end; ++label)
+		if (*label)
+		{
+			LabelType root = forest.find(*label);
+			if (!local[root])
+				local[root] = ++count;
+			*label = local[root];
+		}
+	return count;
+}
+} // DEM
+} // CloudTools
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+#include <gdal_pam.h>
+
+#include "Helper.h"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a raster band whose blocks are computed on demand when read.
+/// </summary>
+/// <remarks>
+/// The computed blocks are kept by the block cache of GDAL. Optionally the recently computed blocks are also kept
+/// in a least recently used cache of the band, so they are not recomputed when evicted from the GDAL block cache.
+/// The blocks might be computed concurrently, so the provider must be thread-safe. The band is read-only.
+/// </remarks>
+template <typename DataType>
+class ComputedRasterBand : public GDALPamRasterBand
+{
+public:
+	/// <summary>
+	/// The callback function computing a rectangular area of the band.
+	/// </summary>
+	/// <remarks>
+	/// Receives the offset and the size of the area and the row-major target buffer of the area.
+	/// </remarks>
+	typedef std::function<void(int, int, int, int, DataType*)> ProviderType;
+
+private:
+	ProviderType _provider;
+	std::size_t _cacheSize;
+
+	std::list<int> _recentBlocks;
+	std::unordered_map<int, std::pair<std::vector<DataType>, std::list<int>::iterator>> _cachedBlocks;
+	std::mutex _cacheMutex;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="dataset">The owner dataset.</param>
+	/// <param name="band">The index of the band.</param>
+	/// <param name="blockSizeX">The width of a block.</param>
+	/// <param name="blockSizeY">The height of a block.</param>
+	/// <param name="provider">The callback function computing the blocks.</param>
+	/// <param name="cacheSize">The maximal number of computed blocks to keep, 0 to disable the cache of the band.</param>
+	ComputedRasterBand(GDALDataset* dataset, int band,
+	                   int blockSizeX, int blockSizeY,
+	                   ProviderType provider, std::size_t cacheSize)
+		: _provider(provider), _cacheSize(cacheSize)
+	{
+		poDS = dataset;
+		nBand = band;
+		nRasterXSize = dataset->GetRasterXSize();
+		nRasterYSize = dataset->GetRasterYSize();
+		eDataType = gdalType<DataType>();
+		eAccess = GA_ReadOnly;
+		nBlockXSize = blockSizeX;
+		nBlockYSize = blockSizeY;
+	}
+
+	ComputedRasterBand(const ComputedRasterBand&) = delete;
+	ComputedRasterBand& operator=(const ComputedRasterBand&) = delete;
+
+protected:
+	/// <summary>
+	/// Computes or retrieves from the cache a block of the band.
+	/// </summary>
+	CPLErr IReadBlock(int blockX, int blockY, void* image) override;
+};
+
+template <typename DataType>
+CPLErr ComputedRasterBand<DataType>::IReadBlock(int blockX, int blockY, void* image)
+{
+	int blockCountX = (nRasterXSize + nBlockXSize - 1) / nBlockXSize;
+	int key = blockY * blockCountX + blockX;
+	std::size_t blockSize = static_cast<std::size_t>(nBlockXSize) * nBlockYSize;
+
+	std::vector<DataType> block;
+	if (_cacheSize > 0)
+	{
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		auto cached = _cachedBlocks.find(key);
+		if (cached != _cachedBlocks.end())
+		{
+			_recentBlocks.splice(_recentBlocks.begin(), _recentBlocks, cached->second.second);
+			std::copy(cached->second.first.begin(), cached->second.first.end(), static_cast<DataType*>(image));
+			return CE_None;
+		}
+
+		// Reuse the buffer of the least recently used block if the cache is full
+		if (_cachedBlocks.size() >= _cacheSize)
+		{
+			auto evicted = _cachedBlocks.find(_recentBlocks.back());
+			block.swap(evicted->second.first);
+			_cachedBlocks.erase(evicted);
+			_recentBlocks.pop_back();
+		}
+	}
+	block.assign(blockSize, 0);
+
+	// Partial blocks at the edges are computed in their valid area only,
+	// the computation is performed without locking, so blocks can be computed concurrently
+	int offsetX = blockX * nBlockXSize;
+	int offsetY = blockY * nBlockYSize;
+	int sizeX = std::min(nBlockXSize, nRasterXSize - offsetX);
+	int sizeY = std::min(nBlockYSize, nRasterYSize - offsetY);
+	try
+	{
+		_provider(offsetX, offsetY, sizeX, sizeY, block.data());
+	}
+	catch (std::exception& ex)
+	{
+		CPLError(CE_Failure, CPLE_AppDefined, "%s", ex.what());
+		return CE_Failure;
+	}
+	if (sizeX < nBlockXSize)
+		for (int j = sizeY - 1; j > 0; --j)
+			std::copy_backward(block.begin() + static_cast<std::size_t>(j) * sizeX,
+				block.begin() + static_cast<std::size_t>(j + 1) * sizeX,
+				block.begin() + static_cast<std::size_t>(j) * nBlockXSize + sizeX);
+
+	std::copy(block.begin(), block.end(), static_cast<DataType*>(image));
+	if (_cacheSize > 0)
+	{
+		// The block might have been computed by a concurrent read meanwhile
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		if (_cachedBlocks.find(key) == _cachedBlocks.end())
+		{
+			if (_cachedBlocks.size() >= _cacheSize)
+			{
+				_cachedBlocks.erase(_recentBlocks.back());
+				_recentBlocks.pop_back();
+			}
+			_recentBlocks.push_front(key);
+			_cachedBlocks.emplace(key, std::make_pair(std::move(block), _recentBlocks.begin()));
+		}
+	}
+	return CE_None;
+}
+
+/// <summary>
+/// Represents a single band, read-only dataset whose blocks are computed on demand when read.
+/// </summary>
+/// <remarks>
+/// Nothing is computed at creation, a consumer reading only a part of the raster
+/// pays only for the blocks it touches.
+/// </remarks>
+template <typename DataType>
+class ComputedDataset : public GDALPamDataset
+{
+public:
+	typedef typename ComputedRasterBand<DataType>::ProviderType ProviderType;
+
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="sizeX">The width of the raster.</param>
+	/// <param name="sizeY">The height of the raster.</param>
+	/// <param name="blockSizeX">The width of a computed block.</param>
+	/// <param name="blockSizeY">The height of a computed block.</param>
+	/// <param name="provider">The callback function computing the blocks.</param>
+	/// <param name="cacheSize">The maximal number of computed blocks to keep, 0 to disable the cache of the band.</param>
+	ComputedDataset(int sizeX, int sizeY,
+	                int blockSizeX, int blockSizeY,
+	                ProviderType provider, std::size_t cacheSize)
+	{
+		if (sizeX < 0 || sizeY < 0 || blockSizeX < 1 || blockSizeY < 1)
+			throw std::invalid_argument("Invalid raster dimensions.");
+
+		nRasterXSize = sizeX;
+		nRasterYSize = sizeY;
+		eAccess = GA_ReadOnly;
+		SetBand(1, new ComputedRasterBand<DataType>(this, 1, blockSizeX, blockSizeY, provider, cacheSize));
+	}
+
+	ComputedDataset(const ComputedDataset&) = delete;
+	ComputedDataset& operator=(const ComputedDataset&) = delete;
+};
+} // DEM
+} // CloudTools
@@ -5,6 +5,7 @@
 
 #include <CloudTools.Common/Operation.h>
 #include "Metadata.h"
+#include "Quantization.hpp"
 
 namespace CloudTools
 {
@@ -40,6 +41,15 @@ public:
 	/// </remarks>
 	double nodataValue = -1e10;
 
+	/// <summary>
+	/// The quantization of the target, disabled by default.
+	/// </summary>
+	/// <remarks>
+	/// When enabled, the target is stored as Int16 with the given scale and offset instead of the target data type.
+	/// The operations not supporting quantization throw <c>std::logic_error</c> when it is enabled.
+	/// </remarks>
+	Quantization quantization;
+
 protected:
 	std::string _targetPath;
 	GDALDataset* _targetDataset = nullptr;
@@ -2,15 +2,21 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <cmath>
 #include <functional>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <exception>
 #include <stdexcept>
 
 #include <boost/filesystem.hpp>
 #include <gdal_priv.h>
 
 #include "Transformation.h"
+#include "TileStore.hpp"
+#include "ParallelFor.hpp"
 #include "Metadata.h"
 #include "Helper.h"
 
@@ -33,11 +39,35 @@ public:
 	/// </summary>
 	std::vector<int> bands;
 
+	/// <summary>
+	/// The memory budget of the raster data in bytes, 0 for no limit.
+	/// </summary>
+	/// <remarks>
+	/// Without limit the rasters are loaded into the memory at once. Otherwise they are paged in tiles
+	/// of <see cref="tileSize"/> on demand, evicting the least recently used tiles when the budget is exceeded,
+	/// so rasters larger than the memory can be processed.
+	/// </remarks>
+	std::size_t memoryLimit = 0;
+
+	/// <summary>
+	/// The width and height of the tiles paged when the memory is limited.
+	/// </summary>
+	int tileSize = 256;
+
+	/// <summary>
+	/// The number of threads to read the sources and to perform the parallel loops of the computation with.
+	/// </summary>
+	/// <remarks>
+	/// With multiple threads the sources are read concurrently with separate dataset handles when possible.
+	/// </remarks>
+	unsigned int threadCount = 1;
+
 protected:
-	std::vector<SourceType*> _sourceData;
+	std::vector<std::unique_ptr<TileStore<SourceType>>> _sourceTiles;
 
 private:
 	std::vector<SourceType> _sourceNodataValue;
+	std::map<GDALDataset*, std::unique_ptr<std::mutex>> _datasetMutexes;
 
 public:
 	/// <summary>
@@ -69,8 +99,6 @@ public:
 	DatasetCalculation(const DatasetCalculation&) = delete;
 	DatasetCalculation& operator=(const DatasetCalculation&) = delete;
 
-	~DatasetCalculation();
-
 protected:
 	/// <summary>
 	/// Produces the target file.
@@ -81,7 +109,7 @@ protected:
 	{
 		if (!isValid(index, i, j))
 			return _sourceNodataValue[index];
-		return _sourceData[index][j * _sourceMetadata[index].rasterSizeX() + i];
+		return _sourceTiles[index]->get(i, j);
 	}
 
 	SourceType sourceData(int i, int j) const
@@ -101,7 +129,98 @@ protected:
 		return hasSourceData(0, i, j);
 	}
 
+	/// <summary>
+	/// Performs an operation for each index of a range parallelly with <see cref="threadCount"/> threads.
+	/// </summary>
+	/// <remarks>
+	/// The raster data accessors are safe to use from the operation, writing distinct target positions.
+	/// The paged stores serialize their accesses, and the accesses of the stores reading bands of the same dataset.
+	/// </remarks>
+	/// <param name="count">The number of indices, e.g. rows (the range is [0, count)).</param>
+	/// <param name="operation">The operation called with the index.</param>
+	template <typename Operation>
+	void parallelFor(int count, const Operation& operation) const
+	{
+		DEM::parallelFor(count, threadCount, operation);
+	}
+
 private:
+	/// <summary>
+	/// Reads the sources into their stores, parallelly on separate dataset handles when possible.
+	/// </summary>
+	/// <param name="sourceBands">The source bands.</param>
+	/// <param name="computationSteps">The number of progress steps of the execution.</param>
+	void readSources(const std::vector<GDALRasterBand*>& sourceBands, int computationSteps)
+	{
+		std::vector<GDALDataset*> handles(sourceCount(), nullptr);
+		if (threadCount > 1)
+		{
+			for (GDALDataset* dataset : _sourceDatasets)
+				dataset->FlushCache();
+			for (unsigned int i = 0; i < sourceCount(); ++i)
+				handles[i] = openSourceHandle(i);
+		}
+
+		int sourcesRead = 0;
+		std::mutex progressMutex;
+		auto readSource = [&](int i)
+		{
+			_sourceTiles[i]->preload(handles[i] != nullptr ? handles[i]->GetRasterBand(sourceBands[i]->GetBand()) : nullptr);
+
+			std::lock_guard<std::mutex> lock(progressMutex);
+			++sourcesRead;
+			if (progress)
+				progress(sourcesRead * 1.f / computationSteps, "Done reading source #" + std::to_string(i + 1));
+		};
+
+		std::exception_ptr error;
+		try
+		{
+			// Sources without a separate handle are read serially
+			parallelFor(static_cast<int>(sourceCount()), [&](int i)
+			{
+				if (handles[i] != nullptr)
+					readSource(i);
+			});
+			for (unsigned int i = 0; i < sourceCount(); ++i)
+				if (handles[i] == nullptr)
+					readSource(i);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		for (GDALDataset* dataset : handles)
+			if (dataset != nullptr)
+				GDALClose(dataset);
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	/// <summary>
+	/// Creates a paged store of a raster band within the memory budget.
+	/// </summary>
+	/// <param name="band">The raster band.</param>
+	/// <param name="storeCount">The number of stores sharing the memory budget.</param>
+	/// <param name="writable">Specifies whether the band is modified through the store.</param>
+	/// <param name="fillValue">The initial value of a writable band.</param>
+	template <typename DataType>
+	TileStore<DataType>* createTileStore(GDALRasterBand* band, std::size_t storeCount,
+	                                     bool writable = false, DataType fillValue = 0) const
+	{
+		if (memoryLimit == 0)
+			return new TileStore<DataType>(band,
+				std::max(band->GetXSize(), 1), std::max(band->GetYSize(), 1), 1,
+				writable, fillValue);
+
+		std::size_t tileBytes = static_cast<std::size_t>(tileSize) * tileSize * sizeof(DataType);
+		return new TileStore<DataType>(band, tileSize, tileSize,
+			memoryLimit / storeCount / tileBytes,
+			writable, fillValue);
+	}
+
 	bool isValid(int i, int j) const
 	{
 		return i >= 0 && i < _targetMetadata.rasterSizeX() &&
@@ -146,7 +265,7 @@ void DatasetCalculation<SourceType>::onExecute()
 				: std::count(_sourceDatasets.begin(), _sourceDatasets.begin() + i, _sourceDatasets[i]) + 1;
 		}
 		sourceBands[i] = _sourceDatasets[i]->GetRasterBand(static_cast<int>(bandIndex));
-		_sourceNodataValue[i] = static_cast<SourceType>(sourceBands[i]->GetNoDataValue());
+		_sourceNodataValue[i] = static_cast<SourceType>(Quantization::nodataValue(sourceBands[i]));
 	}
 
 	if (strictTypes && std::any_of(sourceBands.begin(), sourceBands.end(),
@@ -156,28 +275,22 @@ void DatasetCalculation<SourceType>::onExecute()
 	}))
 		throw std::domain_error("The data type of a source band does not match with the given data type.");
 
-	// Read sources
-	_sourceData.resize(sourceCount());
+	// Read sources (at once without memory limit, otherwise on demand)
+	_sourceTiles.clear();
 	for (unsigned int i = 0; i < sourceCount(); ++i)
-		_sourceData[i] = new SourceType[_sourceMetadata[i].rasterSizeX() * _sourceMetadata[i].rasterSizeY()];
-	
-	CPLErr ioResult = CE_None;
+		_sourceTiles.emplace_back(createTileStore<SourceType>(sourceBands[i], sourceCount()));
+	if (memoryLimit == 0)
+		readSources(sourceBands, computationSteps);
+
+	// The stores of the bands of a dataset read through the same handle, so they are guarded together
+	_datasetMutexes.clear();
 	for (unsigned int i = 0; i < sourceCount(); ++i)
 	{
-		ioResult = static_cast<CPLErr>(ioResult |
-			sourceBands[i]->RasterIO(GF_Read,
-				0, 0,
-				_sourceMetadata[i].rasterSizeX(), _sourceMetadata[i].rasterSizeY(),
-				_sourceData[i], 
-				_sourceMetadata[i].rasterSizeX(), _sourceMetadata[i].rasterSizeY(),
-				sourceType, 
-				0, 0));
-
-		if (progress)
-			progress((i + 1) * 1.f / computationSteps, "Done reading source #" + std::to_string(i + 1));
+		std::unique_ptr<std::mutex>& mutex = _datasetMutexes[_sourceDatasets[i]];
+		if (!mutex)
+			mutex.reset(new std::mutex());
+		_sourceTiles[i]->setConcurrent(threadCount > 1, mutex.get());
 	}
-	if (ioResult != CE_None)
-		throw std::runtime_error("Source read error occured.");
 
 	// Execute computation
 	ProgressType origProgress = progress;
@@ -198,15 +311,5 @@ void DatasetCalculation<SourceType>::onExecute()
 	if (progress)
 		progress(1.f, "Target written");
 }
-
-template <typename SourceType>
-DatasetCalculation<SourceType>::~DatasetCalculation()
-{
-	if (isExecuted())
-	{
-		for (std::size_t i = 0; i < sourceCount(); ++i)
-			delete[] _sourceData[i];
-	}
-}
 } // DEM
 } // CloudTools
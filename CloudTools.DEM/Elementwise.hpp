@@ -0,0 +1,358 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <gdal_priv.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CLOUDTOOLS_SIMD_X86
+#define CLOUDTOOLS_SIMD_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define CLOUDTOOLS_SIMD_X86
+#define CLOUDTOOLS_SIMD_TARGET(isa)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents the instruction set extensions available for the elementwise kernels.
+/// </summary>
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+/// <summary>
+/// Detects the instruction set extensions supported by the CPU and the operating system.
+/// </summary>
+inline SimdLevel detectSimdLevel()
+{
+#if defined(CLOUDTOOLS_SIMD_X86) && !defined(_MSC_VER)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SimdLevel::SSE2;
+#elif defined(CLOUDTOOLS_SIMD_X86)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] >> 26) & 1;
+	bool avx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+	if (avx && maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		if ((info[1] >> 5) & 1)
+			return SimdLevel::AVX2;
+	}
+	if (sse2)
+		return SimdLevel::SSE2;
+#endif
+	return SimdLevel::Scalar;
+}
+
+/// <summary>
+/// Gets the instruction set extensions used by the elementwise kernels, detected once at the first call.
+/// </summary>
+inline SimdLevel simdLevel()
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+/// <summary>
+/// Retrieves the greatest single precision value not greater than the given value.
+/// </summary>
+/// <remarks>
+/// For any single precision <c>x</c>, <c>x &gt; value</c> holds exactly if <c>x &gt; floatBelow(value)</c>.
+/// </remarks>
+inline float floatBelow(double value)
+{
+	if (value >= std::numeric_limits<float>::max())
+		return value == std::numeric_limits<double>::infinity()
+			? std::numeric_limits<float>::infinity()
+			: std::numeric_limits<float>::max();
+	if (value < std::numeric_limits<float>::lowest())
+		return -std::numeric_limits<float>::infinity();
+	float result = static_cast<float>(value);
+	return static_cast<double>(result) > value
+		? std::nextafter(result, -std::numeric_limits<float>::infinity())
+		: result;
+}
+
+/// <summary>
+/// Retrieves the least single precision value not less than the given value.
+/// </summary>
+/// <remarks>
+/// For any single precision <c>x</c>, <c>x &lt; value</c> holds exactly if <c>x &lt; floatAbove(value)</c>.
+/// </remarks>
+inline float floatAbove(double value)
+{
+	return -floatBelow(-value);
+}
+
+/// <summary>
+/// Selects the data where the condition holds and nodata elsewhere.
+/// </summary>
+/// <param name="data">The row of data.</param>
+/// <param name="condition">The row of conditions, non-zero to keep the data.</param>
+/// <param name="size">The length of the row.</param>
+/// <param name="nodataValue">The nodata value.</param>
+/// <param name="target">The target row, may alias the data.</param>
+template <typename DataType>
+void selectValid(const DataType* data, const GByte* condition, int size, DataType nodataValue, DataType* target)
+{
+	for (int x = 0; x < size; ++x)
+		target[x] = condition[x] ? data[x] : nodataValue;
+}
+
+/// <summary>
+/// Keeps the data not less than a threshold where the condition holds and sets nodata elsewhere.
+/// </summary>
+/// <param name="data">The row of data.</param>
+/// <param name="condition">The row of conditions, non-zero to consider the data.</param>
+/// <param name="size">The length of the row.</param>
+/// <param name="threshold">The threshold, the data less than it is discarded.</param>
+/// <param name="nodataValue">The nodata value.</param>
+/// <param name="target">The target row, may alias the data.</param>
+template <typename DataType>
+void thresholdSelect(const DataType* data, const GByte* condition, int size,
+                     DataType threshold, DataType nodataValue, DataType* target)
+{
+	for (int x = 0; x < size; ++x)
+		target[x] = condition[x] && !(data[x] < threshold) ? data[x] : nodataValue;
+}
+
+/// <summary>
+/// Computes the differences of two rows, keeping the ones whose magnitude is strictly between the thresholds.
+/// </summary>
+/// <param name="minuend">The row of minuends.</param>
+/// <param name="subtrahend">The row of subtrahends.</param>
+/// <param name="condition">The row of conditions, non-zero to compute the difference.</param>
+/// <param name="size">The length of the row.</param>
+/// <param name="minimumThreshold">The differences of this or smaller magnitude are discarded.</param>
+/// <param name="maximumThreshold">The differences of this or greater magnitude are discarded.</param>
+/// <param name="nodataValue">The nodata value.</param>
+/// <param name="target">The target row.</param>
+template <typename SourceType, typename TargetType>
+void thresholdedDifference(const SourceType* minuend, const SourceType* subtrahend, const GByte* condition, int size,
+                           double minimumThreshold, double maximumThreshold,
+                           TargetType nodataValue, TargetType* target)
+{
+	for (int x = 0; x < size; ++x)
+	{
+		TargetType difference = static_cast<TargetType>(minuend[x]) - static_cast<TargetType>(subtrahend[x]);
+		bool keep = condition[x] &&
+			std::abs(difference) < maximumThreshold && std::abs(difference) > minimumThreshold;
+		target[x] = keep ? difference : nodataValue;
+	}
+}
+
+#ifdef CLOUDTOOLS_SIMD_X86
+// The x86 kernels process the rows in vectors and the remainders by the scalar kernels.
+// The conditions are widened from bytes to 32 bit lane masks.
+
+CLOUDTOOLS_SIMD_TARGET("sse2")
+inline __m128 conditionMaskSSE2(const GByte* condition)
+{
+	int bytes;
+	std::memcpy(&bytes, condition, sizeof(bytes));
+	__m128i zero = _mm_setzero_si128();
+	__m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+	return _mm_castsi128_ps(_mm_cmpgt_epi32(lanes, zero));
+}
+
+CLOUDTOOLS_SIMD_TARGET("sse2")
+inline __m128 blendSSE2(__m128 mask, __m128 value, __m128 otherwise)
+{
+	return _mm_or_ps(_mm_and_ps(mask, value), _mm_andnot_ps(mask, otherwise));
+}
+
+CLOUDTOOLS_SIMD_TARGET("avx2")
+inline __m256 conditionMaskAVX2(const GByte* condition)
+{
+	__m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(condition)));
+	return _mm256_castsi256_ps(_mm256_cmpgt_epi32(lanes, _mm256_setzero_si256()));
+}
+
+CLOUDTOOLS_SIMD_TARGET("sse2")
+inline int selectValidSSE2(const float* data, const GByte* condition, int size, float nodataValue, float* target)
+{
+	__m128 nodata = _mm_set1_ps(nodataValue);
+	int x = 0;
+	for (; x + 4 <= size; x += 4)
+		_mm_storeu_ps(target + x, blendSSE2(conditionMaskSSE2(condition + x), _mm_loadu_ps(data + x), nodata));
+	return x;
+}
+
+CLOUDTOOLS_SIMD_TARGET("avx2")
+inline int selectValidAVX2(const float* data, const GByte* condition, int size, float nodataValue, float* target)
+{
+	__m256 nodata = _mm256_set1_ps(nodataValue);
+	int x = 0;
+	for (; x + 8 <= size; x += 8)
+		_mm256_storeu_ps(target + x, _mm256_blendv_ps(nodata, _mm256_loadu_ps(data + x), conditionMaskAVX2(condition + x)));
+	return x;
+}
+
+CLOUDTOOLS_SIMD_TARGET("sse2")
+inline int thresholdSelectSSE2(const float* data, const GByte* condition, int size,
+                               float threshold, float nodataValue, float* target)
+{
+	__m128 limit = _mm_set1_ps(threshold);
+	__m128 nodata = _mm_set1_ps(nodataValue);
+	int x = 0;
+	for (; x + 4 <= size; x += 4)
+	{
+		__m128 value = _mm_loadu_ps(data + x);
+		__m128 mask = _mm_and_ps(conditionMaskSSE2(condition + x), _mm_cmpnlt_ps(value, limit));
+		_mm_storeu_ps(target + x, blendSSE2(mask, value, nodata));
+	}
+	return x;
+}
+
+CLOUDTOOLS_SIMD_TARGET("avx2")
+inline int thresholdSelectAVX2(const float* data, const GByte* condition, int size,
+                               float threshold, float nodataValue, float* target)
+{
+	__m256 limit = _mm256_set1_ps(threshold);
+	__m256 nodata = _mm256_set1_ps(nodataValue);
+	int x = 0;
+	for (; x + 8 <= size; x += 8)
+	{
+		__m256 value = _mm256_loadu_ps(data + x);
+		__m256 mask = _mm256_and_ps(conditionMaskAVX2(condition + x), _mm256_cmp_ps(value, limit, _CMP_NLT_UQ));
+		_mm256_storeu_ps(target + x, _mm256_blendv_ps(nodata, value, mask));
+	}
+	return x;
+}
+
+CLOUDTOOLS_SIMD_TARGET("sse2")
+inline int thresholdedDifferenceSSE2(const float* minuend, const float* subtrahend, const GByte* condition, int size,
+                                     float minimumThreshold, float maximumThreshold,
+                                     float nodataValue, float* target)
+{
+	__m128 minimum = _mm_set1_ps(minimumThreshold);
+	__m128 maximum = _mm_set1_ps(maximumThreshold);
+	__m128 nodata = _mm_set1_ps(nodataValue);
+	__m128 sign = _mm_set1_ps(-0.f);
+	int x = 0;
+	for (; x + 4 <= size; x += 4)
+	{
+		__m128 difference = _mm_sub_ps(_mm_loadu_ps(minuend + x), _mm_loadu_ps(subtrahend + x));
+		__m128 magnitude = _mm_andnot_ps(sign, difference);
+		__m128 mask = _mm_and_ps(conditionMaskSSE2(condition + x),
+			_mm_and_ps(_mm_cmplt_ps(magnitude, maximum), _mm_cmpgt_ps(magnitude, minimum)));
+		_mm_storeu_ps(target + x, blendSSE2(mask, difference, nodata));
+	}
+	return x;
+}
+
+CLOUDTOOLS_SIMD_TARGET("avx2")
+inline int thresholdedDifferenceAVX2(const float* minuend, const float* subtrahend, const GByte* condition, int size,
+                                     float minimumThreshold, float maximumThreshold,
+                                     float nodataValue, float* target)
+{
+	__m256 minimum = _mm256_set1_ps(minimumThreshold);
+	__m256 maximum = _mm256_set1_ps(maximumThreshold);
+	__m256 nodata = _mm256_set1_ps(nodataValue);
+	__m256 sign = _mm256_set1_ps(-0.f);
+	int x = 0;
+	for (; x + 8 <= size; x += 8)
+	{
+		__m256 difference = _mm256_sub_ps(_mm256_loadu_ps(minuend + x), _mm256_loadu_ps(subtrahend + x));
+		__m256 magnitude = _mm256_andnot_ps(sign, difference);
+		__m256 mask = _mm256_and_ps(conditionMaskAVX2(condition + x),
+			_mm256_and_ps(_mm256_cmp_ps(magnitude, maximum, _CMP_LT_OQ), _mm256_cmp_ps(magnitude, minimum, _CMP_GT_OQ)));
+		_mm256_storeu_ps(target + x, _mm256_blendv_ps(nodata, difference, mask));
+	}
+	return x;
+}
+#endif
+
+/// <summary>
+/// Selects the data where the condition holds and nodata elsewhere, vectorized by the detected instruction set.
+/// </summary>
+inline void selectValid(const float* data, const GByte* condition, int size, float nodataValue, float* target)
+{
+	int done = 0;
+#ifdef CLOUDTOOLS_SIMD_X86
+	switch (simdLevel())
+	{
+	case SimdLevel::AVX2:
+		done = selectValidAVX2(data, condition, size, nodataValue, target);
+		break;
+	case SimdLevel::SSE2:
+		done = selectValidSSE2(data, condition, size, nodataValue, target);
+		break;
+	default:
+		break;
+	}
+#endif
+	selectValid<float>(data + done, condition + done, size - done, nodataValue, target + done);
+}
+
+/// <summary>
+/// Keeps the data not less than a threshold where the condition holds, vectorized by the detected instruction set.
+/// </summary>
+inline void thresholdSelect(const float* data, const GByte* condition, int size,
+                            float threshold, float nodataValue, float* target)
+{
+	int done = 0;
+#ifdef CLOUDTOOLS_SIMD_X86
+	switch (simdLevel())
+	{
+	case SimdLevel::AVX2:
+		done = thresholdSelectAVX2(data, condition, size, threshold, nodataValue, target);
+		break;
+	case SimdLevel::SSE2:
+		done = thresholdSelectSSE2(data, condition, size, threshold, nodataValue, target);
+		break;
+	default:
+		break;
+	}
+#endif
+	thresholdSelect<float>(data + done, condition + done, size - done, threshold, nodataValue, target + done);
+}
+
+/// <summary>
+/// Computes the thresholded differences of two rows, vectorized by the detected instruction set.
+/// </summary>
+/// <remarks>
+/// The thresholds are rounded outwards to single precision, so the result equals to the one of the scalar kernel.
+/// </remarks>
+inline void thresholdedDifference(const float* minuend, const float* subtrahend, const GByte* condition, int size,
+                                  double minimumThreshold, double maximumThreshold,
+                                  float nodataValue, float* target)
+{
+	int done = 0;
+#ifdef CLOUDTOOLS_SIMD_X86
+	switch (simdLevel())
+	{
+	case SimdLevel::AVX2:
+		done = thresholdedDifferenceAVX2(minuend, subtrahend, condition, size,
+			floatBelow(minimumThreshold), floatAbove(maximumThreshold), nodataValue, target);
+		break;
+	case SimdLevel::SSE2:
+		done = thresholdedDifferenceSSE2(minuend, subtrahend, condition, size,
+			floatBelow(minimumThreshold), floatAbove(maximumThreshold), nodataValue, target);
+		break;
+	default:
+		break;
+	}
+#endif
+	thresholdedDifference<float, float>(minuend + done, subtrahend + done, condition + done, size - done,
+		minimumThreshold, maximumThreshold, nodataValue, target + done);
+}
+} // DEM
+} // CloudTools
@@ -9,6 +9,8 @@
 #include "../Transformation.h"
 #include "../SweepLineTransformation.hpp"
 #include "../Window.hpp"
+#include "../RowWindow.hpp"
+#include "../Elementwise.hpp"
 
 namespace CloudTools
 {
@@ -174,19 +176,26 @@ void ClusterFilter<DataType>::onExecute()
 	// Apply sieve filter on input
 	SweepLineTransformation<DataType> filter(std::vector<GDALDataset*>{_sourceDatasets[0], _sieveDataset},
 		_targetPath, 0, nullptr, _progressFilter);
-	filter.computation = [&filter]
-	(int x, int y, const std::vector<Window<DataType>>& sources)
+	filter.rowComputation = [&filter]
+	(int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
 	{
-		const Window<DataType>& data = sources[0];
-		const Window<DataType>& sieve = sources[1];
-
-		if (sieve.hasData() && sieve.data() == 255) return data.data();
-		else return static_cast<DataType>(filter.nodataValue);
+		const int sizeX = sources[0].sizeX();
+		const GByte* dataValid = sources[0].valid();
+		const DataType* sieve = sources[1].data();
+		const GByte* sieveValid = sources[1].valid();
+
+		// Small nodata regions merged into a kept cluster by the sieve remain nodata
+		std::vector<GByte> condition(sizeX);
+		for (int x = 0; x < sizeX; ++x)
+			condition[x] = dataValid[x] & sieveValid[x] & (sieve[x] == 255);
+		selectValid(sources[0].data(), condition.data(), sizeX, static_cast<DataType>(filter.nodataValue), target);
 	};
 	filter.nodataValue = nodataValue;
 	filter.targetFormat = targetFormat;
 	filter.createOptions = createOptions;
 	filter.spatialReference = spatialReference;
+	filter.quantization = quantization;
+	filter.sparse = true;
 	filter.execute();
 	_targetDataset = filter.target();
 }
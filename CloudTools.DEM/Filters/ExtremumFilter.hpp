@@ -0,0 +1,169 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../RowWindow.hpp"
+#include "../SlidingExtremum.hpp"
+#include "../SweepLineTransformation.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a sliding maximum or minimum filter for DEM datasets.
+/// </summary>
+/// <remarks>
+/// Each target position receives the extremum of the valid source data in the <c>(2 * range + 1)^2</c> sized
+/// window around it, or nodata if the window contains no valid data.
+/// Consecutive rows are streamed through a <see cref="SlidingExtremum"/> per worker thread,
+/// so the cost per position is independent of the range.
+/// </remarks>
+template <typename DataType = float>
+class ExtremumFilter : public SweepLineTransformation<DataType>
+{
+public:
+	typedef typename SlidingExtremum<DataType>::Method Method;
+
+	/// <summary>
+	/// The computed extremum.
+	/// </summary>
+	Method method;
+
+private:
+	/// <summary>
+	/// Represents the state of the rows streamed by a worker thread.
+	/// </summary>
+	struct Sweep
+	{
+		std::unique_ptr<SlidingExtremum<DataType>> extremum;
+		int nextRow = 0;
+	};
+
+	std::map<std::thread::id, Sweep> _sweeps;
+	std::mutex _sweepMutex;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class. Loads input metadata and defines computation.
+	/// </summary>
+	/// <param name="sourcePath">The source path of the filter.</param>
+	/// <param name="targetPath">The target file of the filter.</param>
+	/// <param name="range">The range of the window.</param>
+	/// <param name="method">The computed extremum.</param>
+	/// <param name="progress">The callback method to report progress.</param>
+	ExtremumFilter(const std::string& sourcePath,
+	               const std::string& targetPath,
+	               int range,
+	               Method method = Method::Maximum,
+	               Operation::ProgressType progress = nullptr)
+		: SweepLineTransformation<DataType>({ sourcePath }, targetPath, range, nullptr, progress),
+		  method(method)
+	{
+		initialize();
+	}
+
+	/// <summary>
+	/// Initializes a new instance of the class. Loads input metadata and defines computation.
+	/// </summary>
+	/// <remarks>
+	/// Target is in memory raster by default and can be retrieved by <see cref="target()"/>.
+	/// </remarks>
+	/// <param name="sourceDataset">The source dataset of the filter.</param>
+	/// <param name="range">The range of the window.</param>
+	/// <param name="method">The computed extremum.</param>
+	/// <param name="progress">The callback method to report progress.</param>
+	ExtremumFilter(GDALDataset* sourceDataset,
+	               int range,
+	               Method method = Method::Maximum,
+	               Operation::ProgressType progress = nullptr)
+		: SweepLineTransformation<DataType>({ sourceDataset }, range, nullptr, progress),
+		  method(method)
+	{
+		initialize();
+	}
+
+	/// <summary>
+	/// Initializes a new instance of the class. Loads input metadata and defines computation.
+	/// </summary>
+	/// <param name="sourceDataset">The source dataset of the filter.</param>
+	/// <param name="targetPath">The target file of the filter.</param>
+	/// <param name="range">The range of the window.</param>
+	/// <param name="method">The computed extremum.</param>
+	/// <param name="progress">The callback method to report progress.</param>
+	ExtremumFilter(GDALDataset* sourceDataset,
+	               const std::string& targetPath,
+	               int range,
+	               Method method = Method::Maximum,
+	               Operation::ProgressType progress = nullptr)
+		: SweepLineTransformation<DataType>({ sourceDataset }, targetPath, range, nullptr, progress),
+		  method(method)
+	{
+		initialize();
+	}
+
+	ExtremumFilter(const ExtremumFilter&) = delete;
+	ExtremumFilter& operator=(const ExtremumFilter&) = delete;
+
+protected:
+	void onExecute() override
+	{
+		_sweeps.clear();
+		SweepLineTransformation<DataType>::onExecute();
+	}
+
+private:
+	/// <summary>
+	/// Initializes the new instance of the class.
+	/// </summary>
+	void initialize();
+
+	/// <summary>
+	/// Retrieves the state of the rows streamed by the current thread.
+	/// </summary>
+	Sweep& sweep()
+	{
+		std::lock_guard<std::mutex> lock(_sweepMutex);
+		return _sweeps[std::this_thread::get_id()];
+	}
+};
+
+template <typename DataType>
+void ExtremumFilter<DataType>::initialize()
+{
+	this->rowComputation = [this](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
+	{
+		const RowWindow<DataType>& source = sources[0];
+		const int sizeX = source.sizeX();
+		const int range = source.range();
+
+		Sweep& sweep = this->sweep();
+		if (!sweep.extremum || sweep.extremum->method() != this->method
+		    || sweep.extremum->sizeX() != sizeX || sweep.extremum->range() != range)
+			sweep.extremum.reset(new SlidingExtremum<DataType>(sizeX, range, this->method));
+		SlidingExtremum<DataType>& extremum = *sweep.extremum;
+
+		// Continuing the sweep of the thread only requires the new bottom row of the window
+		if (extremum.ready() && sweep.nextRow == y)
+			extremum.push(source.data(range), source.valid(range));
+		else
+		{
+			extremum.reset();
+			for (int j = -range; j <= range; ++j)
+				extremum.push(source.data(j), source.valid(j));
+		}
+		sweep.nextRow = y + 1;
+
+		const DataType* result = extremum.result();
+		const DataType empty = extremum.identity();
+		for (int x = 0; x < sizeX; ++x)
+			target[x] = result[x] != empty ? result[x] : static_cast<DataType>(this->nodataValue);
+	};
+}
+} // DEM
+} // CloudTools
@@ -2,8 +2,10 @@
 
 #include <cmath>
 #include <string>
+#include <vector>
 
-#include "../Window.hpp"
+#include "../RowWindow.hpp"
+#include "../BoxStatistics.hpp"
 #include "../SweepLineTransformation.hpp"
 
 namespace CloudTools
@@ -52,11 +54,33 @@ public:
 	MajorityFilter(const MajorityFilter&) = delete;
 	MajorityFilter& operator=(const MajorityFilter&) = delete;
 
+	/// <summary>
+	/// Creates the row computation of the filter, e.g. for a stage of a <see cref="SweepLinePipeline"/>.
+	/// </summary>
+	/// <remarks>
+	/// The computation requires the column statistics of the row windows.
+	/// </remarks>
+	/// <param name="range">The range of surrounding data to involve.</param>
+	/// <param name="nodataValue">The nodata value of the result.</param>
+	static typename SweepLineTransformation<DataType>::RowComputationType createRowComputation(
+		int range, double nodataValue = 0)
+	{
+		return [range, nodataValue](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
+		{
+			filter(sources[0], range, static_cast<DataType>(nodataValue), target);
+		};
+	}
+
 private:
 	/// <summary>
 	/// Initializes the new instance of the class.
 	/// </summary>
 	void initialize();
+
+	/// <summary>
+	/// Computes the filtered values of the center row of a window.
+	/// </summary>
+	static void filter(const RowWindow<DataType>& source, int range, DataType nodataValue, DataType* target);
 };
 
 template <typename DataType>
@@ -65,24 +89,38 @@ void MajorityFilter<DataType>::initialize()
 	// http://desktop.arcgis.com/en/arcmap/10.3/tools/spatial-analyst-toolbox/majority-filter.htm
 	// http://desktop.arcgis.com/en/arcmap/10.3/tools/spatial-analyst-toolbox/smoothing-zone-edges-with-boundary-clean-and-majority-filter.htm
 
-	this->computation = [this](int x, int y, const std::vector<Window<DataType>>& sources)
+	// The box sums and counts are slid over the maintained column statistics,
+	// so the cost per pixel is independent of the range
+	this->rowComputation = [this](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
 	{
-		const Window<DataType>& source = sources[0];
-
-		float sum = 0;
-		int counter = 0;
-		for (int i = -this->range(); i <= this->range(); ++i)
-			for (int j = -this->range(); j <= this->range(); ++j)
-				if (source.hasData(i, j))
-				{
-					sum += source.data(i, j);
-					++counter;
-				}
-
-		if (counter < (std::pow(this->range() * 2 + 1, 2) / 2)) return static_cast<DataType>(this->nodataValue);
-		else return source.hasData() ? source.data() : sum / counter;
+		filter(sources[0], this->range(), static_cast<DataType>(this->nodataValue), target);
 	};
+	this->columnStatistics = true;
 	this->nodataValue = 0;
+	this->sparse = true;
+}
+
+template <typename DataType>
+void MajorityFilter<DataType>::filter(const RowWindow<DataType>& source, int range, DataType nodataValue, DataType* target)
+{
+	const int sizeX = source.sizeX();
+
+	std::vector<double> sums(sizeX);
+	std::vector<int> counters(sizeX);
+	boxStatistics(source, sums.data(), counters.data());
+
+	const double minimumCount = std::pow(range * 2 + 1, 2) / 2;
+	const DataType* center = source.data();
+	const GByte* centerValid = source.valid();
+	for (int x = 0; x < sizeX; ++x)
+	{
+		if (counters[x] < minimumCount)
+			target[x] = nodataValue;
+		else if (centerValid[x])
+			target[x] = center[x];
+		else
+			target[x] = static_cast<DataType>(static_cast<float>(sums[x]) / counters[x]);
+	}
 }
 } // DEM
 } // CloudTools
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-#include "../Window.hpp"
+#include "../RowWindow.hpp"
+#include "../BoxStatistics.hpp"
 #include "../SweepLineTransformation.hpp"
 
 namespace CloudTools
@@ -72,11 +74,35 @@ public:
 	MorphologyFilter(const MorphologyFilter&) = delete;
 	MorphologyFilter& operator=(const MorphologyFilter&) = delete;
 
+	/// <summary>
+	/// Creates the row computation of the filter, e.g. for a stage of a <see cref="SweepLinePipeline"/>.
+	/// </summary>
+	/// <remarks>
+	/// The computation requires the column statistics of the row windows.
+	/// </remarks>
+	/// <param name="method">The applied morphology method.</param>
+	/// <param name="threshold">Threshold value for morphology filter, -1 for the default of the method.</param>
+	/// <param name="nodataValue">The nodata value of the result.</param>
+	static typename SweepLineTransformation<DataType>::RowComputationType createRowComputation(
+		Method method = Method::Dilation, int threshold = -1, double nodataValue = 0)
+	{
+		return [method, threshold, nodataValue](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
+		{
+			filter(sources[0], method, threshold, static_cast<DataType>(nodataValue), target);
+		};
+	}
+
 private:
 	/// <summary>
 	/// Initializes the new instance of the class.
 	/// </summary>
 	void initialize();
+
+	/// <summary>
+	/// Computes the filtered values of the center row of a window.
+	/// </summary>
+	static void filter(const RowWindow<DataType>& source, Method method, int threshold,
+	                   DataType nodataValue, DataType* target);
 };
 
 template <typename DataType>
@@ -85,32 +111,46 @@ void MorphologyFilter<DataType>::initialize()
 	// https://en.wikipedia.org/wiki/Mathematical_morphology
 	// https://www.cs.auckland.ac.nz/courses/compsci773s1c/lectures/ImageProcessing-html/topic4.htm
 
-	this->computation = [this](int x, int y, const std::vector<Window<DataType>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<DataType>>& sources, DataType* target)
 	{
-		if (this->method == Method::Dilation && this->threshold == -1)
-			this->threshold = 0;
-	  	if (this->method == Method::Erosion && this->threshold == -1)
-	  		this->threshold = 9;
-
-		const Window<DataType>& source = sources[0];
-
-		float sum = 0;
-		int counter = 0;
-		for (int i = -1; i <= 1; ++i)
-			for (int j = -1; j <= 1; ++j)
-				if (source.hasData(i, j))
-				{
-					sum += source.data(i, j);
-					++counter;
-				}
-
-		if (this->method == Method::Dilation && !source.hasData() && counter > this->threshold)
-			return sum / counter;
-		if (this->method == Method::Erosion && source.hasData() && counter < this->threshold)
-			return static_cast<DataType>(this->nodataValue);
-		return source.hasData() ? source.data() : static_cast<DataType>(this->nodataValue);
+		filter(sources[0], this->method, this->threshold, static_cast<DataType>(this->nodataValue), target);
 	};
+	this->columnStatistics = true;
 	this->nodataValue = 0;
+	this->sparse = true;
+}
+
+template <typename DataType>
+void MorphologyFilter<DataType>::filter(const RowWindow<DataType>& source, Method method, int threshold,
+                                        DataType nodataValue, DataType* target)
+{
+	if (method == Method::Dilation && threshold == -1)
+		threshold = 0;
+	if (method == Method::Erosion && threshold == -1)
+		threshold = 9;
+
+	const int sizeX = source.sizeX();
+
+	std::vector<double> sums(sizeX);
+	std::vector<int> counters(sizeX);
+	boxStatistics(source, sums.data(), counters.data());
+
+	const DataType* center = source.data();
+	const GByte* centerValid = source.valid();
+	for (int x = 0; x < sizeX; ++x)
+	{
+		if (centerValid[x])
+		{
+			if (method == Method::Erosion && counters[x] < threshold)
+				target[x] = nodataValue;
+			else
+				target[x] = center[x];
+		}
+		else if (method == Method::Dilation && counters[x] > threshold)
+			target[x] = static_cast<DataType>(static_cast<float>(sums[x]) / counters[x]);
+		else
+			target[x] = nodataValue;
+	}
 }
 } // DEM
 } // CloudTools
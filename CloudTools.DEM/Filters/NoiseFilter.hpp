@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <string>
+#include <vector>
 #include <algorithm>
 
 #include "../SweepLineTransformation.hpp"
@@ -62,38 +63,64 @@ public:
 	NoiseFilter(const NoiseFilter&) = delete;
 	NoiseFilter& operator=(const NoiseFilter&) = delete;
 
+	/// <summary>
+	/// Creates the computation of the filter, e.g. for a stage of a <see cref="SweepLinePipeline"/>.
+	/// </summary>
+	/// <param name="range">The range of surrounding data to involve.</param>
+	/// <param name="threshold">The threshold of noise in percentage (between values 0 and 1).</param>
+	/// <param name="nodataValue">The nodata value of the result.</param>
+	static typename SweepLineTransformation<DataType>::ComputationType createComputation(
+		int range, double threshold = 0.5, double nodataValue = 0)
+	{
+		return [range, threshold, nodataValue](int x, int y, const std::vector<Window<DataType>>& sources)
+		{
+			return filter(sources[0], range, threshold, static_cast<DataType>(nodataValue));
+		};
+	}
+
 private:
 	/// <summary>
 	/// Initializes the new instance of the class.
 	/// </summary>
 	void initialize();
+
+	/// <summary>
+	/// Computes the filtered value of the center of a window.
+	/// </summary>
+	static DataType filter(const Window<DataType>& source, int range, double threshold, DataType nodataValue);
 };
 
 template <typename DataType>
 void NoiseFilter<DataType>::initialize()
 {
-	// Noise is the average percentage of difference compared to the surrounding area.
 	this->computation = [this](int x, int y, const std::vector<Window<DataType>>& sources)
 	{
-		const Window<DataType>& source = sources[0];
-		if (!source.hasData()) return static_cast<DataType>(this->nodataValue);
-
-		float noise = 0;
-		int counter = -1;
-		for (int i = -this->range(); i <= this->range(); ++i)
-			for (int j = -this->range(); j <= this->range(); ++j)
-				if (source.hasData(i, j))
-				{
-					noise += std::abs(source.data() - source.data(i, j))
-						/ std::min(std::abs(source.data()), std::abs(source.data(i, j)));
-					++counter;
-				}
-
-		if (counter == 0) return static_cast<DataType>(this->nodataValue);
-		if (noise / counter > this->threshold) return static_cast<DataType>(this->nodataValue);
-		else return source.data();
+		return filter(sources[0], this->range(), this->threshold, static_cast<DataType>(this->nodataValue));
 	};
 	this->nodataValue = 0;
+	this->sparse = true;
+}
+
+template <typename DataType>
+DataType NoiseFilter<DataType>::filter(const Window<DataType>& source, int range, double threshold, DataType nodataValue)
+{
+	// Noise is the average percentage of difference compared to the surrounding area.
+	if (!source.hasData()) return nodataValue;
+
+	float noise = 0;
+	int counter = -1;
+	for (int i = -range; i <= range; ++i)
+		for (int j = -range; j <= range; ++j)
+			if (source.hasData(i, j))
+			{
+				noise += std::abs(source.data() - source.data(i, j))
+					/ std::min(std::abs(source.data()), std::abs(source.data(i, j)));
+				++counter;
+			}
+
+	if (counter == 0) return nodataValue;
+	if (noise / counter > threshold) return nodataValue;
+	else return source.data();
 }
 } // DEM
 } // CloudTools
@@ -30,6 +30,24 @@ GDALDataType gdalType(std::string& dataType)
 	return GDALDataType::GDT_Unknown;
 }
 
+bool isSupportedType(GDALDataType dataType)
+{
+	switch (dataType)
+	{
+	case GDALDataType::GDT_Byte:
+	case GDALDataType::GDT_UInt16:
+	case GDALDataType::GDT_Int16:
+	case GDALDataType::GDT_UInt32:
+	case GDALDataType::GDT_Int32:
+	case GDALDataType::GDT_Float32:
+	case GDALDataType::GDT_Float64:
+		return true;
+	default:
+		// Complex types are not supported.
+		return false;
+	}
+}
+
 std::string SRSName(const OGRSpatialReference& reference)
 {
 	const char* authorityName = reference.GetAuthorityName(nullptr);
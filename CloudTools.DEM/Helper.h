@@ -2,7 +2,8 @@
 
 #include <string>
 #include <utility>
-#include <typeinfo>
+#include <stdexcept>
+#include <functional>
 
 #include <boost/functional/hash/hash.hpp>
 
@@ -13,30 +14,120 @@ namespace CloudTools
 {
 namespace DEM
 {
+/// <summary>
+/// Maps a C++ type to the corresponding GDAL type at compile time.
+/// </summary>
+/// <remarks>
+/// Complex types are not supported, their value is <c>GDT_Unknown</c>.
+/// </remarks>
+template <typename T>
+struct GDALTypeOf
+{
+	static const GDALDataType value = GDALDataType::GDT_Unknown;
+};
+
+template <> struct GDALTypeOf<GByte> { static const GDALDataType value = GDALDataType::GDT_Byte; };
+template <> struct GDALTypeOf<GUInt16> { static const GDALDataType value = GDALDataType::GDT_UInt16; };
+template <> struct GDALTypeOf<GInt16> { static const GDALDataType value = GDALDataType::GDT_Int16; };
+template <> struct GDALTypeOf<GUInt32> { static const GDALDataType value = GDALDataType::GDT_UInt32; };
+template <> struct GDALTypeOf<GInt32> { static const GDALDataType value = GDALDataType::GDT_Int32; };
+template <> struct GDALTypeOf<float> { static const GDALDataType value = GDALDataType::GDT_Float32; };
+template <> struct GDALTypeOf<double> { static const GDALDataType value = GDALDataType::GDT_Float64; };
+
+/// <summary>
+/// Maps a GDAL type to the corresponding C++ type at compile time.
+/// </summary>
+template <GDALDataType Type>
+struct GDALTypeTraits;
+
+template <> struct GDALTypeTraits<GDALDataType::GDT_Byte> { typedef GByte type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_UInt16> { typedef GUInt16 type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_Int16> { typedef GInt16 type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_UInt32> { typedef GUInt32 type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_Int32> { typedef GInt32 type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_Float32> { typedef float type; };
+template <> struct GDALTypeTraits<GDALDataType::GDT_Float64> { typedef double type; };
+
 /// <summary>
 /// Returns the GDAL type for <paramref name="T" />.
 /// </summary>
 template <typename T>
 GDALDataType gdalType()
 {
-	const std::type_info& typeInfo = typeid(T);
-	if (typeInfo == typeid(GByte))
-		return GDALDataType::GDT_Byte;
-	if (typeInfo == typeid(GUInt16))
-		return GDALDataType::GDT_UInt16;
-	if (typeInfo == typeid(GInt16))
-		return GDALDataType::GDT_Int16;
-	if (typeInfo == typeid(GUInt32))
-		return GDALDataType::GDT_UInt32;
-	if (typeInfo == typeid(GInt32))
-		return GDALDataType::GDT_Int32;
-	if (typeInfo == typeid(float))
-		return GDALDataType::GDT_Float32;
-	if (typeInfo == typeid(double))
-		return GDALDataType::GDT_Float64;
-	
-	// Complex types are not supported.
-	return GDALDataType::GDT_Unknown;
+	return GDALTypeOf<T>::value;
+}
+
+/// <summary>
+/// Represents a C++ type as a value, used to select the instantiation in <see cref="dispatchType"/>.
+/// </summary>
+template <typename T>
+struct TypeTag
+{
+	typedef T type;
+};
+
+/// <summary>
+/// Determines whether a GDAL type is supported by <see cref="dispatchType"/>.
+/// </summary>
+/// <param name="dataType">The GDAL type.</param>
+bool isSupportedType(GDALDataType dataType);
+
+/// <summary>
+/// Invokes a functor with the C++ type corresponding to a GDAL type determined at runtime.
+/// </summary>
+/// <remarks>
+/// The functor must be callable with a <see cref="TypeTag"/> of each supported type,
+/// e.g. through a member template <c>template &lt;typename T&gt; R operator()(TypeTag&lt;T&gt;) const</c>,
+/// so a single call site instantiates the processing for every supported GDAL type.
+/// </remarks>
+/// <param name="dataType">The GDAL type.</param>
+/// <param name="functor">The functor to invoke.</param>
+/// <returns>The result of the functor.</returns>
+/// <exception cref="std::invalid_argument">The GDAL type is not supported.</exception>
+template <typename Functor>
+auto dispatchType(GDALDataType dataType, Functor&& functor) -> decltype(functor(TypeTag<float>()))
+{
+	switch (dataType)
+	{
+	case GDALDataType::GDT_Byte:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_Byte>::type>());
+	case GDALDataType::GDT_UInt16:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_UInt16>::type>());
+	case GDALDataType::GDT_Int16:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_Int16>::type>());
+	case GDALDataType::GDT_UInt32:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_UInt32>::type>());
+	case GDALDataType::GDT_Int32:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_Int32>::type>());
+	case GDALDataType::GDT_Float32:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_Float32>::type>());
+	case GDALDataType::GDT_Float64:
+		return functor(TypeTag<GDALTypeTraits<GDALDataType::GDT_Float64>::type>());
+	default:
+		// Complex types are not supported.
+		throw std::invalid_argument("Unsupported data type.");
+	}
+}
+
+/// <summary>
+/// Determines whether a callable object is defined.
+/// </summary>
+/// <remarks>
+/// Functor and lambda objects are always defined.
+/// </remarks>
+template <typename Function>
+bool isDefined(const Function&)
+{
+	return true;
+}
+
+/// <summary>
+/// Determines whether a function wrapper has a target.
+/// </summary>
+template <typename Signature>
+bool isDefined(const std::function<Signature>& function)
+{
+	return static_cast<bool>(function);
 }
 
 /// <summary>
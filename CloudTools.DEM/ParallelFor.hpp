@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <future>
+#include <exception>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Performs an operation for each index of a range parallelly.
+/// </summary>
+/// <remarks>
+/// The range is split into contiguous parts of nearly equal size, each processed on a separate thread
+/// in increasing order of the indices. The operation is performed on the calling thread for a single part.
+/// The first exception thrown by the operation is rethrown after all parts have finished.
+/// </remarks>
+/// <param name="count">The number of indices (the range is [0, count)).</param>
+/// <param name="threadCount">The maximal number of threads to use.</param>
+/// <param name="operation">The operation called with the index.</param>
+template <typename Operation>
+void parallelFor(int count, unsigned int threadCount, const Operation& operation)
+{
+	int partCount = static_cast<int>(std::min<long long>(std::max(threadCount, 1u), std::max(count, 1)));
+	auto processPart = [count, partCount, &operation](int part)
+	{
+		int first = static_cast<int>(1LL * count * part / partCount);
+		int last = static_cast<int>(1LL * count * (part + 1) / partCount);
+		for (int index = first; index < last; ++index)
+			operation(index);
+	};
+
+	if (partCount == 1)
+	{
+		processPart(0);
+		return;
+	}
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(partCount);
+	for (int part = 0; part < partCount; ++part)
+		futures.push_back(std::async(std::launch::async, processPart, part));
+
+	std::exception_ptr error;
+	for (auto& future : futures)
+	{
+		try
+		{
+			future.get();
+		}
+		catch (...)
+		{
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+} // DEM
+} // CloudTools
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <gdal_priv.h>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents the linear quantization of a raster to 16 bit integers.
+/// </summary>
+/// <remarks>
+/// A value is stored as <c>round((value - offset) / scale)</c> and read back as <c>stored * scale + offset</c>,
+/// e.g. the scale of 0.01 stores heights in centimetres. The scale and the offset are recorded on the raster band,
+/// so the readers of the sweepline and dataset operations dequantize the data transparently.
+/// Only the Int16 bands with <see cref="storedNodataValue"/> as nodata are considered quantized,
+/// the scale and offset metadata of other bands is ignored.
+/// </remarks>
+struct Quantization
+{
+	/// <summary>
+	/// The stored value of nodata in quantized rasters.
+	/// </summary>
+	static const GInt16 storedNodataValue = std::numeric_limits<GInt16>::min();
+
+	/// <summary>
+	/// <c>true</c> if the quantization is applied, <c>false</c> otherwise.
+	/// </summary>
+	bool enabled = false;
+
+	/// <summary>
+	/// The size of a quantization step.
+	/// </summary>
+	double scale = 1.0;
+
+	/// <summary>
+	/// The value represented by the stored zero.
+	/// </summary>
+	double offset = 0.0;
+
+	/// <summary>
+	/// Initializes a new instance of the struct with disabled quantization.
+	/// </summary>
+	Quantization() = default;
+
+	/// <summary>
+	/// Initializes a new instance of the struct with enabled quantization.
+	/// </summary>
+	/// <param name="scale">The size of a quantization step.</param>
+	/// <param name="offset">The value represented by the stored zero.</param>
+	Quantization(double scale, double offset = 0.0)
+		: enabled(true), scale(scale), offset(offset)
+	{ }
+
+	/// <summary>
+	/// Retrieves the quantization recorded on a raster band.
+	/// </summary>
+	/// <returns>The quantization; disabled if the band was not quantized by <see cref="apply"/>.</returns>
+	static Quantization of(GDALRasterBand* band)
+	{
+		int hasNodata = 0;
+		double nodataValue = band->GetNoDataValue(&hasNodata);
+		if (band->GetRasterDataType() != GDT_Int16 || !hasNodata || nodataValue != storedNodataValue)
+			return Quantization();
+
+		double scale = band->GetScale();
+		double offset = band->GetOffset();
+		if (scale == 1.0 && offset == 0.0)
+			return Quantization();
+		return Quantization(scale, offset);
+	}
+
+	/// <summary>
+	/// Retrieves the nodata value of a raster band as seen by the computations, i.e. dequantized.
+	/// </summary>
+	static double nodataValue(GDALRasterBand* band)
+	{
+		return of(band).dequantize(band->GetNoDataValue());
+	}
+
+	/// <summary>
+	/// Records the quantization on a raster band.
+	/// </summary>
+	void apply(GDALRasterBand* band) const
+	{
+		if (!enabled)
+			return;
+		band->SetScale(scale);
+		band->SetOffset(offset);
+		band->SetNoDataValue(storedNodataValue);
+	}
+
+	/// <summary>
+	/// Converts a stored value to its represented value.
+	/// </summary>
+	double dequantize(double stored) const
+	{
+		return enabled ? stored * scale + offset : stored;
+	}
+
+	/// <summary>
+	/// Dequantizes stored values in place.
+	/// </summary>
+	/// <remarks>
+	/// Nodata is transformed as any other value, so it equals <see cref="nodataValue"/> afterwards.
+	/// </remarks>
+	template <typename DataType>
+	void dequantize(DataType* data, std::size_t count) const
+	{
+		if (!enabled)
+			return;
+		for (std::size_t i = 0; i < count; ++i)
+			data[i] = static_cast<DataType>(data[i] * scale + offset);
+	}
+
+	/// <summary>
+	/// Quantizes values in place before storing them.
+	/// </summary>
+	/// <remarks>
+	/// Values out of the representable range are saturated.
+	/// </remarks>
+	/// <param name="data">The values.</param>
+	/// <param name="count">The number of values.</param>
+	/// <param name="nodataValue">The nodata value of the values, which is stored as <see cref="storedNodataValue"/>.</param>
+	template <typename DataType>
+	void quantize(DataType* data, std::size_t count, double nodataValue) const
+	{
+		if (!enabled)
+			return;
+		const double lowest = storedNodataValue + 1;
+		const double highest = std::numeric_limits<GInt16>::max();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			double stored = data[i] == static_cast<DataType>(nodataValue)
+				? storedNodataValue
+				: std::min(std::max(std::round((data[i] - offset) / scale), lowest), highest);
+			data[i] = static_cast<DataType>(stored);
+		}
+	}
+};
+} // DEM
+} // CloudTools
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include "Helper.h"
+#include "ValidityMask.hpp"
+#include "Quantization.hpp"
+#include "AsyncScanlineIO.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a window of whole scanlines around a target row.
+/// </summary>
+/// <remarks>
+/// The scanlines are aligned to the target raster: the element <c>data(j)[x]</c> belongs to the
+/// target position <c>(x, y + j)</c> for any <c>-range &lt;= x &lt; sizeX + range</c>.
+/// Positions without valid data contain the nodata value and their validity mask element is zero,
+/// so kernels can process the scanlines in tight, branchless loops.
+/// </remarks>
+template <typename DataType>
+struct RowWindow
+{
+private:
+	const DataType* const* _data;
+	const GByte* const* _valid;
+	const double* _columnSums;
+	const int* _columnCounts;
+	DataType _nodataValue;
+	int _sizeX;
+	int _range;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the struct.
+	/// </summary>
+	/// <param name="data">The aligned data row pointers, ordered from <c>-range</c> to <c>range</c>.</param>
+	/// <param name="valid">The aligned validity mask row pointers, ordered from <c>-range</c> to <c>range</c>.</param>
+	/// <param name="nodataValue">The nodata value.</param>
+	/// <param name="sizeX">The width of the target.</param>
+	/// <param name="range">The range of the window.</param>
+	/// <param name="columnSums">The aligned sums of the valid data in the columns of the window, if maintained.</param>
+	/// <param name="columnCounts">The aligned numbers of the valid data in the columns of the window, if maintained.</param>
+	RowWindow(const DataType* const* data, const GByte* const* valid,
+	          DataType nodataValue, int sizeX, int range,
+	          const double* columnSums = nullptr, const int* columnCounts = nullptr)
+		: _data(data), _valid(valid), _columnSums(columnSums), _columnCounts(columnCounts),
+		  _nodataValue(nodataValue), _sizeX(sizeX), _range(range)
+	{ }
+
+	/// <summary>
+	/// Gets the width of the target.
+	/// </summary>
+	int sizeX() const { return _sizeX; }
+
+	/// <summary>
+	/// Gets the range of the window.
+	/// </summary>
+	int range() const { return _range; }
+
+	/// <summary>
+	/// Gets the nodata value.
+	/// </summary>
+	DataType nodataValue() const { return _nodataValue; }
+
+	/// <summary>
+	/// Retrieves the data of the scanline at the specified ordinate relative to the target row.
+	/// </summary>
+	/// <param name="j">Relative ordinate.</param>
+	const DataType* data(int j = 0) const
+	{
+		return _data[j + _range];
+	}
+
+	/// <summary>
+	/// Retrieves the validity mask (1 for valid data, 0 otherwise) of the scanline at the specified ordinate relative to the target row.
+	/// </summary>
+	/// <param name="j">Relative ordinate.</param>
+	const GByte* valid(int j = 0) const
+	{
+		return _valid[j + _range];
+	}
+
+	/// <summary>
+	/// Retrieves the sums of the valid data in the <c>2 * range + 1</c> high columns of the window.
+	/// </summary>
+	/// <remarks>
+	/// The sums are aligned in the same way as the scanlines.
+	/// </remarks>
+	/// <returns>The column sums; or <c>nullptr</c> if they are not maintained.</returns>
+	const double* columnSums() const
+	{
+		return _columnSums;
+	}
+
+	/// <summary>
+	/// Retrieves the numbers of the valid data in the <c>2 * range + 1</c> high columns of the window.
+	/// </summary>
+	/// <remarks>
+	/// The counts are aligned in the same way as the scanlines.
+	/// </remarks>
+	/// <returns>The column counts; or <c>nullptr</c> if they are not maintained.</returns>
+	const int* columnCounts() const
+	{
+		return _columnCounts;
+	}
+};
+
+/// <summary>
+/// Represents a rolling cache of the target aligned scanlines of a raster band for row windows.
+/// </summary>
+/// <remarks>
+/// Each scanline is read from the band and masked only once while the target row advances monotonically.
+/// The validity combines the nodata value and the mask band of the raster band if it has one.
+/// Instead of a raster band, the scanlines can also be produced by a provider callback,
+/// e.g. by the previous stage of a pipeline.
+/// Optionally the sums and the counts of the valid data in the columns of the window are maintained
+/// incrementally, adding the entering and subtracting the leaving scanline when advancing by one row.
+/// </remarks>
+template <typename DataType>
+class RowWindowCache
+{
+public:
+	/// <summary>
+	/// The callback function producing a target aligned scanline of <c>sizeX</c> elements.
+	/// </summary>
+	typedef std::function<void(int, DataType*)> ProviderType;
+
+private:
+	GDALRasterBand* _band;
+	ProviderType _provider;
+	GDALRasterBand* _maskBand;
+	std::mutex* _bandMutex;
+	Quantization _quantization;
+	DataType _nodataValue;
+	int _sizeX;
+	int _range;
+	int _offsetX;
+	int _offsetY;
+	int _sourceSizeX;
+	int _sourceSizeY;
+	int _stride;
+	int _words;
+	int _count;
+
+	std::vector<DataType> _data;
+	std::vector<GByte> _valid;
+	std::vector<GByte> _maskRow;
+	std::vector<std::uint64_t> _bits;
+	std::vector<int> _slotRows;
+	std::vector<bool> _slotFilled;
+	std::vector<const DataType*> _dataRows;
+	std::vector<const GByte*> _validRows;
+	std::vector<const std::uint64_t*> _bitRows;
+	std::unique_ptr<ScanlinePrefetcher<DataType>> _prefetcher;
+
+	bool _columnStatistics;
+	int _columnRow;
+	std::vector<double> _columnSums;
+	std::vector<int> _columnCounts;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="band">The raster band to read the scanlines from.</param>
+	/// <param name="sizeX">The width of the target.</param>
+	/// <param name="range">The range of the windows.</param>
+	/// <param name="offsetX">The abcissa offset of the band in the target.</param>
+	/// <param name="offsetY">The ordinate offset of the band in the target.</param>
+	/// <param name="nodataValue">The nodata value of the band.</param>
+	/// <param name="bandMutex">The mutex guarding the band when shared between threads.</param>
+	RowWindowCache(GDALRasterBand* band, int sizeX, int range,
+	               int offsetX, int offsetY, DataType nodataValue,
+	               std::mutex* bandMutex = nullptr)
+		: _band(band), _maskBand(validityMaskBand(band)), _bandMutex(bandMutex),
+		  _quantization(Quantization::of(band)), _nodataValue(nodataValue),
+		  _sizeX(sizeX), _range(range),
+		  _offsetX(offsetX), _offsetY(offsetY),
+		  _sourceSizeX(band->GetXSize()), _sourceSizeY(band->GetYSize())
+	{
+		initialize();
+		if (_maskBand != nullptr)
+			_maskRow.resize(_stride);
+	}
+
+	/// <summary>
+	/// Initializes a new instance of the class with scanlines produced by a callback.
+	/// </summary>
+	/// <remarks>
+	/// The provider is called for each row of the <c>sizeX * sizeY</c> sized target once,
+	/// in ascending order, while the target row advances monotonically.
+	/// </remarks>
+	/// <param name="provider">The callback function producing the scanlines.</param>
+	/// <param name="sizeX">The width of the target.</param>
+	/// <param name="sizeY">The height of the target.</param>
+	/// <param name="range">The range of the windows.</param>
+	/// <param name="nodataValue">The nodata value of the produced data.</param>
+	RowWindowCache(ProviderType provider, int sizeX, int sizeY, int range, DataType nodataValue)
+		: _band(nullptr), _provider(provider), _maskBand(nullptr), _bandMutex(nullptr), _nodataValue(nodataValue),
+		  _sizeX(sizeX), _range(range),
+		  _offsetX(0), _offsetY(0),
+		  _sourceSizeX(sizeX), _sourceSizeY(sizeY)
+	{
+		initialize();
+	}
+
+	RowWindowCache(const RowWindowCache&) = delete;
+	RowWindowCache& operator=(const RowWindowCache&) = delete;
+
+	/// <summary>
+	/// Retrieves the row window of the last fetched target row.
+	/// </summary>
+	/// <remarks>
+	/// The window is only valid until the next call of <see cref="fetch"/>.
+	/// </remarks>
+	RowWindow<DataType> window() const
+	{
+		return RowWindow<DataType>(_dataRows.data(), _validRows.data(), _nodataValue, _sizeX, _range,
+			_columnStatistics ? &_columnSums[_range] : nullptr,
+			_columnStatistics ? &_columnCounts[_range] : nullptr);
+	}
+
+	/// <summary>
+	/// Sets whether to maintain the sums and the counts of the valid data in the columns of the windows.
+	/// </summary>
+	void setColumnStatistics(bool enabled)
+	{
+		_columnStatistics = enabled;
+		_columnRow = -1;
+		_columnSums.assign(enabled ? _stride : 0, 0.0);
+		_columnCounts.assign(enabled ? _stride : 0, 0);
+	}
+
+	/// <summary>
+	/// Retrieves the target aligned scanline pointers of the last fetched window, ordered from <c>-range</c> to <c>range</c>.
+	/// </summary>
+	/// <remarks>
+	/// The element <c>rows()[j + range][x]</c> belongs to the target position <c>(x, row + j)</c>.
+	/// </remarks>
+	const DataType* const* rows() const
+	{
+		return _dataRows.data();
+	}
+
+	/// <summary>
+	/// Retrieves the packed validity bits of the scanlines of the last fetched window.
+	/// </summary>
+	/// <remarks>
+	/// The bits are aligned to the target in the same way as the <see cref="rows"/>.
+	/// </remarks>
+	const std::uint64_t* const* validity() const
+	{
+		return _bitRows.data();
+	}
+
+	/// <summary>
+	/// Collects the runs of target positions of the last fetched row whose window contains valid data.
+	/// </summary>
+	/// <remarks>
+	/// The runs are computed from the packed validity bits, the padding columns beyond the target are checked separately.
+	/// </remarks>
+	/// <param name="runs">The target of the sorted and disjoint runs.</param>
+	void occupancy(std::vector<ValidityRun>& runs) const
+	{
+		collectValidityRuns(_bitRows.data(), _count, _sizeX, _range, 0, _sizeX, runs);
+
+		// Valid data left and right of the target reaches the windows of the edge positions
+		int leftEnd = 0, rightBegin = _sizeX;
+		for (int j = 0; j < _count; ++j)
+			for (int k = 1; k <= _range; ++k)
+			{
+				if (_validRows[j][-k])
+					leftEnd = std::max(leftEnd, std::min(_sizeX, _range - k + 1));
+				if (_validRows[j][_sizeX - 1 + k])
+					rightBegin = std::min(rightBegin, std::max(0, _sizeX - 1 + k - _range));
+			}
+
+		if (leftEnd > 0)
+		{
+			runs.insert(runs.begin(), ValidityRun{ 0, leftEnd });
+			while (runs.size() > 1 && runs[1].begin <= runs[0].end)
+			{
+				runs[0].end = std::max(runs[0].end, runs[1].end);
+				runs.erase(runs.begin() + 1);
+			}
+		}
+		if (rightBegin < _sizeX)
+		{
+			runs.push_back(ValidityRun{ rightBegin, _sizeX });
+			while (runs.size() > 1 && runs[runs.size() - 2].end >= runs.back().begin)
+			{
+				runs[runs.size() - 2].begin = std::min(runs[runs.size() - 2].begin, runs.back().begin);
+				runs[runs.size() - 2].end = _sizeX;
+				runs.pop_back();
+			}
+		}
+	}
+
+	/// <summary>
+	/// Starts reading ahead the source scanlines of the given range of target rows in the background.
+	/// </summary>
+	/// <remarks>
+	/// The target rows of the range must then be fetched sequentially.
+	/// The band must not be accessed otherwise until the cache is destroyed.
+	/// Has no effect when the scanlines are produced by a provider.
+	/// </remarks>
+	/// <param name="firstRow">The first target row to fetch.</param>
+	/// <param name="lastRow">The row after the last target row to fetch.</param>
+	/// <param name="depth">The maximal number of scanlines to read ahead.</param>
+	void prefetch(int firstRow, int lastRow, int depth)
+	{
+		_prefetcher.reset();
+		if (_band == nullptr)
+			return;
+
+		int firstSourceRow = std::max(0, firstRow - _range - _offsetY);
+		int lastSourceRow = std::min(_sourceSizeY, lastRow + _range - _offsetY);
+		int firstColumn = firstSourceColumn();
+		int lastColumn = lastSourceColumn();
+		if (firstSourceRow < lastSourceRow && firstColumn < lastColumn)
+			_prefetcher.reset(new ScanlinePrefetcher<DataType>(_band,
+				firstSourceRow, lastSourceRow,
+				firstColumn, lastColumn - firstColumn,
+				depth, _bandMutex));
+	}
+
+	/// <summary>
+	/// Makes the scanlines of the window around the given target row available.
+	/// </summary>
+	/// <param name="row">The target row.</param>
+	/// <returns>The result of the raster I/O operations.</returns>
+	CPLErr fetch(int row)
+	{
+		// The leaving scanline is subtracted before its slot is reused by the entering one
+		bool advance = _columnStatistics && _columnRow >= 0 && _columnRow + 1 == row;
+		if (advance)
+			accumulateColumns(row - _range - 1, -1);
+
+		CPLErr ioResult = CE_None;
+		for (int j = -_range; j <= _range; ++j)
+		{
+			int targetRow = row + j;
+			int slot = ((targetRow % _count) + _count) % _count;
+			if (!_slotFilled[slot] || _slotRows[slot] != targetRow)
+			{
+				ioResult = static_cast<CPLErr>(ioResult | load(slot, targetRow));
+				_slotRows[slot] = targetRow;
+				_slotFilled[slot] = true;
+			}
+			_dataRows[j + _range] = &_data[static_cast<std::size_t>(slot) * _stride + _range];
+			_validRows[j + _range] = &_valid[static_cast<std::size_t>(slot) * _stride + _range];
+			_bitRows[j + _range] = _bits.data() + static_cast<std::size_t>(slot) * _words;
+		}
+
+		if (advance)
+			accumulateColumns(row + _range, 1);
+		else if (_columnStatistics)
+		{
+			std::fill(_columnSums.begin(), _columnSums.end(), 0.0);
+			std::fill(_columnCounts.begin(), _columnCounts.end(), 0);
+			for (int j = -_range; j <= _range; ++j)
+				accumulateColumns(row + j, 1);
+		}
+		if (_columnStatistics)
+			_columnRow = row;
+		return ioResult;
+	}
+
+private:
+	void initialize()
+	{
+		if (_sizeX < 0 || _range < 0)
+			throw std::invalid_argument("Negative window dimensions are prohibited.");
+
+		_stride = _sizeX + 2 * _range;
+		_words = validityWords(_sizeX);
+		_count = 2 * _range + 1;
+		_data.resize(static_cast<std::size_t>(_stride) * _count);
+		_valid.resize(static_cast<std::size_t>(_stride) * _count);
+		_bits.resize(static_cast<std::size_t>(_words) * _count);
+		_slotRows.resize(_count);
+		_slotFilled.assign(_count, false);
+		_dataRows.resize(_count);
+		_validRows.resize(_count);
+		_bitRows.resize(_count);
+		_columnStatistics = false;
+		_columnRow = -1;
+	}
+
+	void accumulateColumns(int targetRow, int sign)
+	{
+		int slot = ((targetRow % _count) + _count) % _count;
+		const DataType* data = &_data[static_cast<std::size_t>(slot) * _stride];
+		const GByte* valid = &_valid[static_cast<std::size_t>(slot) * _stride];
+		for (int k = 0; k < _stride; ++k)
+		{
+			_columnCounts[k] += sign * valid[k];
+			// Empty columns are reset to avoid the drift of the running sums
+			_columnSums[k] = _columnCounts[k] == 0 ? 0.0
+				: _columnSums[k] + (valid[k] ? sign * static_cast<double>(data[k]) : 0.0);
+		}
+	}
+
+	int firstSourceColumn() const
+	{
+		return std::max(0, -_range - _offsetX);
+	}
+
+	int lastSourceColumn() const
+	{
+		return std::min(_sourceSizeX, _sizeX + _range - _offsetX);
+	}
+
+	CPLErr load(int slot, int targetRow)
+	{
+		DataType* data = &_data[static_cast<std::size_t>(slot) * _stride];
+		GByte* valid = &_valid[static_cast<std::size_t>(slot) * _stride];
+		std::fill(data, data + _stride, _nodataValue);
+
+		CPLErr ioResult = CE_None;
+		bool masked = false;
+		int sourceRow = targetRow - _offsetY;
+		if (_provider && sourceRow >= 0 && sourceRow < _sourceSizeY)
+			_provider(sourceRow, data + _range);
+		else if (sourceRow >= 0 && sourceRow < _sourceSizeY)
+		{
+			int firstColumn = firstSourceColumn();
+			int lastColumn = lastSourceColumn();
+			if (firstColumn < lastColumn && _prefetcher)
+			{
+				ioResult = _prefetcher->read(sourceRow,
+					data + firstColumn + _offsetX + _range,
+					_maskBand != nullptr ? &_maskRow[firstColumn + _offsetX + _range] : nullptr);
+				if (_maskBand != nullptr)
+				{
+					std::fill(_maskRow.begin(), _maskRow.begin() + firstColumn + _offsetX + _range, 0);
+					std::fill(_maskRow.begin() + lastColumn + _offsetX + _range, _maskRow.end(), 0);
+					masked = true;
+				}
+			}
+			else if (firstColumn < lastColumn)
+			{
+				std::unique_lock<std::mutex> lock;
+				if (_bandMutex != nullptr)
+					lock = std::unique_lock<std::mutex>(*_bandMutex);
+
+				ioResult = _band->RasterIO(GF_Read,
+					firstColumn, sourceRow,
+					lastColumn - firstColumn, 1,
+					data + firstColumn + _offsetX + _range, lastColumn - firstColumn, 1,
+					gdalType<DataType>(), 0, 0);
+				if (_maskBand != nullptr)
+				{
+					std::fill(_maskRow.begin(), _maskRow.end(), 0);
+					ioResult = static_cast<CPLErr>(ioResult | _maskBand->RasterIO(GF_Read,
+						firstColumn, sourceRow,
+						lastColumn - firstColumn, 1,
+						&_maskRow[firstColumn + _offsetX + _range], lastColumn - firstColumn, 1,
+						GDT_Byte, 0, 0));
+					masked = true;
+				}
+			}
+		}
+
+		if (!_provider && sourceRow >= 0 && sourceRow < _sourceSizeY && firstSourceColumn() < lastSourceColumn())
+			_quantization.dequantize(data + firstSourceColumn() + _offsetX + _range,
+				static_cast<std::size_t>(lastSourceColumn() - firstSourceColumn()));
+
+		if (masked)
+			applyMask(data, _maskRow.data(), static_cast<std::size_t>(_stride), _nodataValue);
+		for (int k = 0; k < _stride; ++k)
+			valid[k] = data[k] != _nodataValue;
+		packValidity(data + _range, valid + _range, _sizeX, _nodataValue,
+			_bits.data() + static_cast<std::size_t>(slot) * _words);
+		return ioResult;
+	}
+};
+} // DEM
+} // CloudTools
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include "Helper.h"
+#include "ValidityMask.hpp"
+#include "Quantization.hpp"
+#include "AsyncScanlineIO.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a rolling ring-buffer cache of consecutive scanlines of a raster band.
+/// </summary>
+/// <remarks>
+/// Each scanline is read from the band only once while the cached range advances monotonically,
+/// the row buffers of the leaving scanlines are reused for the entering ones by rotating the row pointers.
+/// The validity of each scanline is packed into bits once when read, combining the nodata value
+/// and the mask band of the raster band if it has one. The masked out positions contain the nodata value.
+/// </remarks>
+template <typename DataType>
+class ScanlineCache
+{
+private:
+	GDALRasterBand* _band;
+	GDALRasterBand* _maskBand;
+	std::mutex* _bandMutex;
+	Quantization _quantization;
+	DataType _nodataValue;
+	int _sizeX;
+	int _sizeY;
+	int _capacity;
+	int _words;
+
+	DataType* _buffer;
+	std::vector<DataType*> _rows;
+	std::vector<DataType*> _spare;
+	std::vector<std::uint64_t> _bits;
+	std::vector<const std::uint64_t*> _validity;
+	std::vector<GByte> _maskRow;
+	std::unique_ptr<ScanlinePrefetcher<DataType>> _prefetcher;
+	int _firstRow;
+	int _rowCount;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="band">The raster band to read the scanlines from.</param>
+	/// <param name="capacity">The maximal number of scanlines to cache.</param>
+	/// <param name="bandMutex">The mutex guarding the band when shared between threads.</param>
+	ScanlineCache(GDALRasterBand* band, int capacity, std::mutex* bandMutex = nullptr)
+		: _band(band), _maskBand(validityMaskBand(band)), _bandMutex(bandMutex),
+		  _quantization(Quantization::of(band)),
+		  _nodataValue(static_cast<DataType>(Quantization::nodataValue(band))),
+		  _sizeX(band->GetXSize()), _sizeY(band->GetYSize()),
+		  _capacity(capacity), _words(validityWords(_sizeX)),
+		  _firstRow(0), _rowCount(0)
+	{
+		if (_capacity < 1)
+			throw std::invalid_argument("The capacity of the cache must be positive.");
+
+		_buffer = new DataType[static_cast<std::size_t>(_sizeX) * _capacity];
+		_bits.resize(static_cast<std::size_t>(_words) * _capacity);
+		if (_maskBand != nullptr)
+			_maskRow.resize(_sizeX);
+		_rows.reserve(_capacity);
+		_spare.reserve(_capacity);
+		_validity.reserve(_capacity);
+		for (int i = _capacity - 1; i >= 0; --i)
+			_spare.push_back(_buffer + static_cast<std::size_t>(i) * _sizeX);
+	}
+
+	ScanlineCache(const ScanlineCache&) = delete;
+	ScanlineCache& operator=(const ScanlineCache&) = delete;
+
+	~ScanlineCache()
+	{
+		delete[] _buffer;
+	}
+
+	/// <summary>
+	/// Gets the width of the cached scanlines.
+	/// </summary>
+	int sizeX() const { return _sizeX; }
+
+	/// <summary>
+	/// Gets the index of the first cached scanline.
+	/// </summary>
+	int firstRow() const { return _firstRow; }
+
+	/// <summary>
+	/// Gets the number of cached scanlines.
+	/// </summary>
+	int rowCount() const { return _rowCount; }
+
+	/// <summary>
+	/// Retrieves the row pointers of the cached scanlines in order.
+	/// </summary>
+	/// <remarks>
+	/// The pointers are only valid until the next call of <see cref="fetch"/>.
+	/// </remarks>
+	const DataType* const* rows() const { return _rows.data(); }
+
+	/// <summary>
+	/// Retrieves the packed validity bits of the cached scanlines in order.
+	/// </summary>
+	/// <remarks>
+	/// The pointers are only valid until the next call of <see cref="fetch"/>.
+	/// </remarks>
+	const std::uint64_t* const* validity() const { return _validity.data(); }
+
+	/// <summary>
+	/// Starts reading ahead the given range of scanlines in the background.
+	/// </summary>
+	/// <remarks>
+	/// The cache must then be advanced monotonically, so that the scanlines of the range are
+	/// requested sequentially. The band must not be accessed otherwise until the cache is destroyed.
+	/// </remarks>
+	/// <param name="firstRow">The first scanline to read ahead.</param>
+	/// <param name="lastRow">The scanline after the last scanline to read ahead.</param>
+	/// <param name="depth">The maximal number of scanlines to read ahead.</param>
+	void prefetch(int firstRow, int lastRow, int depth)
+	{
+		_prefetcher.reset();
+		if (firstRow < lastRow && _sizeX > 0)
+			_prefetcher.reset(new ScanlinePrefetcher<DataType>(_band,
+				firstRow, lastRow, 0, _sizeX, depth, _bandMutex));
+	}
+
+	/// <summary>
+	/// Makes the given range of scanlines available in the cache.
+	/// </summary>
+	/// <remarks>
+	/// Only the scanlines not already cached are read from the band.
+	/// </remarks>
+	/// <param name="firstRow">The index of the first scanline.</param>
+	/// <param name="rowCount">The number of scanlines.</param>
+	/// <returns>The result of the raster I/O operations.</returns>
+	CPLErr fetch(int firstRow, int rowCount)
+	{
+		if (rowCount < 0 || rowCount > _capacity)
+			throw std::out_of_range("The requested scanline range exceeds the capacity of the cache.");
+		if (firstRow < 0 || firstRow + rowCount > _sizeY)
+			throw std::out_of_range("The requested scanline range is out of the raster.");
+
+		// Release the scanlines leaving the cached range
+		int keepFirst = std::max(firstRow, _firstRow);
+		int keepLast = std::min(firstRow + rowCount, _firstRow + _rowCount);
+		if (keepFirst >= keepLast)
+		{
+			_spare.insert(_spare.end(), _rows.begin(), _rows.end());
+			_rows.clear();
+			keepFirst = keepLast = firstRow;
+		}
+		else
+		{
+			_spare.insert(_spare.end(), _rows.begin() + (keepLast - _firstRow), _rows.end());
+			_rows.erase(_rows.begin() + (keepLast - _firstRow), _rows.end());
+			_spare.insert(_spare.end(), _rows.begin(), _rows.begin() + (keepFirst - _firstRow));
+			_rows.erase(_rows.begin(), _rows.begin() + (keepFirst - _firstRow));
+		}
+
+		// Read the scanlines entering the cached range
+		CPLErr ioResult = CE_None;
+		for (int row = keepFirst - 1; row >= firstRow; --row)
+		{
+			_rows.insert(_rows.begin(), acquire());
+			ioResult = static_cast<CPLErr>(ioResult | read(row, _rows.front()));
+		}
+		for (int row = keepLast; row < firstRow + rowCount; ++row)
+		{
+			_rows.push_back(acquire());
+			ioResult = static_cast<CPLErr>(ioResult | read(row, _rows.back()));
+		}
+
+		_validity.clear();
+		for (DataType* row : _rows)
+			_validity.push_back(bits(row));
+
+		_firstRow = firstRow;
+		_rowCount = rowCount;
+		return ioResult;
+	}
+
+private:
+	DataType* acquire()
+	{
+		DataType* row = _spare.back();
+		_spare.pop_back();
+		return row;
+	}
+
+	std::uint64_t* bits(const DataType* row)
+	{
+		return _bits.data() + static_cast<std::size_t>((row - _buffer) / std::max(_sizeX, 1)) * _words;
+	}
+
+	CPLErr read(int row, DataType* target)
+	{
+		CPLErr ioResult;
+		if (_prefetcher)
+			ioResult = _prefetcher->read(row, target, _maskBand != nullptr ? &_maskRow[0] : nullptr);
+		else
+		{
+			std::unique_lock<std::mutex> lock;
+			if (_bandMutex != nullptr)
+				lock = std::unique_lock<std::mutex>(*_bandMutex);
+
+			ioResult = _band->RasterIO(GF_Read,
+				0, row,
+				_sizeX, 1,
+				target, _sizeX, 1,
+				gdalType<DataType>(), 0, 0);
+			if (_maskBand != nullptr)
+				ioResult = static_cast<CPLErr>(ioResult | _maskBand->RasterIO(GF_Read,
+					0, row,
+					_sizeX, 1,
+					&_maskRow[0], _sizeX, 1,
+					GDT_Byte, 0, 0));
+		}
+
+		_quantization.dequantize(target, _sizeX);
+		applyMask(target, _maskBand != nullptr ? &_maskRow[0] : nullptr, _sizeX, _nodataValue);
+		packValidity<DataType>(target, _maskBand != nullptr ? &_maskRow[0] : nullptr, _sizeX, _nodataValue, bits(target));
+		return ioResult;
+	}
+};
+} // DEM
+} // CloudTools
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <gdal_priv.h>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Computes the maximum or the minimum in the <c>(2 * range + 1)^2</c> sized box windows of a raster
+/// streamed row by row.
+/// </summary>
+/// <remarks>
+/// Implements the van Herk/Gil-Werman algorithm separably: both the horizontal and the vertical passes
+/// split the sequence into blocks of the window size and combine a suffix extremum of one block with a
+/// prefix extremum of the next one. The cost is about 3 comparisons per position and pass, independent of the range.
+/// Invalid positions are ignored; windows without valid data result in <see cref="identity()"/>.
+/// </remarks>
+template <typename DataType>
+class SlidingExtremum
+{
+public:
+	enum Method
+	{
+		Maximum,
+		Minimum
+	};
+
+private:
+	int _sizeX;
+	int _range;
+	Method _method;
+	int _count;
+
+	std::vector<DataType> _line;
+	std::vector<DataType> _linePrefix;
+	std::vector<DataType> _lineSuffix;
+	std::vector<DataType> _block;
+	std::vector<DataType> _blockSuffix;
+	std::vector<DataType> _blockPrefix;
+	std::vector<DataType> _result;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="sizeX">The width of the rows.</param>
+	/// <param name="range">The range of the window.</param>
+	/// <param name="method">The computed extremum.</param>
+	SlidingExtremum(int sizeX, int range, Method method = Method::Maximum)
+		: _sizeX(sizeX), _range(range), _method(method), _count(0),
+		  _line(sizeX + 2 * range), _linePrefix(sizeX + 2 * range), _lineSuffix(sizeX + 2 * range),
+		  _block(static_cast<std::size_t>(2 * range + 1) * sizeX),
+		  _blockSuffix(static_cast<std::size_t>(2 * range + 1) * sizeX),
+		  _blockPrefix(sizeX), _result(sizeX)
+	{ }
+
+	/// <summary>
+	/// Gets the width of the rows.
+	/// </summary>
+	int sizeX() const { return _sizeX; }
+
+	/// <summary>
+	/// Gets the range of the window.
+	/// </summary>
+	int range() const { return _range; }
+
+	/// <summary>
+	/// Gets the computed extremum.
+	/// </summary>
+	Method method() const { return _method; }
+
+	/// <summary>
+	/// Gets the number of rows pushed since the last reset.
+	/// </summary>
+	int count() const { return _count; }
+
+	/// <summary>
+	/// Gets the value standing for windows without valid data.
+	/// </summary>
+	/// <remarks>
+	/// The lowest value of the data type for maximum, the highest one for minimum.
+	/// </remarks>
+	DataType identity() const
+	{
+		return _method == Method::Maximum
+			? std::numeric_limits<DataType>::lowest()
+			: std::numeric_limits<DataType>::max();
+	}
+
+	/// <summary>
+	/// Determines whether the window of the result row is complete.
+	/// </summary>
+	bool ready() const { return _count >= 2 * _range + 1; }
+
+	/// <summary>
+	/// Retrieves the extrema of the windows centered on the row pushed <c>range</c> rows before the last one.
+	/// </summary>
+	/// <remarks>
+	/// Only valid if the window is complete, see <see cref="ready()"/>.
+	/// </remarks>
+	const DataType* result() const { return _result.data(); }
+
+	/// <summary>
+	/// Restarts the computation with a new sequence of rows.
+	/// </summary>
+	void reset() { _count = 0; }
+
+	/// <summary>
+	/// Pushes the next row of the raster.
+	/// </summary>
+	/// <param name="data">The aligned data of the row, the elements from <c>-range</c> to <c>sizeX + range</c> are read.</param>
+	/// <param name="valid">The aligned validity mask of the row, the elements from <c>-range</c> to <c>sizeX + range</c> are read.</param>
+	void push(const DataType* data, const GByte* valid);
+
+private:
+	DataType select(DataType a, DataType b) const
+	{
+		return _method == Method::Maximum ? std::max(a, b) : std::min(a, b);
+	}
+
+	/// <summary>
+	/// Computes the extrema of the horizontal windows of a row.
+	/// </summary>
+	void horizontal(const DataType* data, const GByte* valid, DataType* target);
+};
+
+template <typename DataType>
+void SlidingExtremum<DataType>::push(const DataType* data, const GByte* valid)
+{
+	const int size = 2 * _range + 1;
+	const int position = _count % size;
+	DataType* row = &_block[static_cast<std::size_t>(position) * _sizeX];
+	horizontal(data, valid, row);
+
+	// Prefix extrema of the current block
+	if (position == 0)
+		std::copy(row, row + _sizeX, _blockPrefix.begin());
+	else
+		for (int x = 0; x < _sizeX; ++x)
+			_blockPrefix[x] = select(_blockPrefix[x], row[x]);
+	++_count;
+
+	// The window of the result spans the suffix of the previous block and the prefix of the current one
+	if (ready())
+	{
+		if (position == size - 1)
+			std::copy(_blockPrefix.begin(), _blockPrefix.end(), _result.begin());
+		else
+		{
+			const DataType* suffix = &_blockSuffix[static_cast<std::size_t>(position + 1) * _sizeX];
+			for (int x = 0; x < _sizeX; ++x)
+				_result[x] = select(suffix[x], _blockPrefix[x]);
+		}
+	}
+
+	// Suffix extrema of the completed block
+	if (position == size - 1)
+	{
+		std::copy(row, row + _sizeX, &_blockSuffix[static_cast<std::size_t>(position) * _sizeX]);
+		for (int j = position - 1; j >= 0; --j)
+		{
+			const DataType* current = &_block[static_cast<std::size_t>(j) * _sizeX];
+			const DataType* next = &_blockSuffix[static_cast<std::size_t>(j + 1) * _sizeX];
+			DataType* suffix = &_blockSuffix[static_cast<std::size_t>(j) * _sizeX];
+			for (int x = 0; x < _sizeX; ++x)
+				suffix[x] = select(current[x], next[x]);
+		}
+	}
+}
+
+template <typename DataType>
+void SlidingExtremum<DataType>::horizontal(const DataType* data, const GByte* valid, DataType* target)
+{
+	const int size = 2 * _range + 1;
+	const int length = _sizeX + 2 * _range;
+	const DataType empty = identity();
+	data -= _range;
+	valid -= _range;
+
+	for (int i = 0; i < length; ++i)
+		_line[i] = valid[i] ? data[i] : empty;
+
+	for (int i = 0; i < length; ++i)
+		_linePrefix[i] = i % size == 0 ? _line[i] : select(_linePrefix[i - 1], _line[i]);
+	for (int i = length - 1; i >= 0; --i)
+		_lineSuffix[i] = i % size == size - 1 || i == length - 1 ? _line[i] : select(_lineSuffix[i + 1], _line[i]);
+
+	// The window of position x covers the padded elements from x to x + 2 * range
+	for (int x = 0; x < _sizeX; ++x)
+		target[x] = select(_lineSuffix[x], _linePrefix[x + size - 1]);
+}
+} // DEM
+} // CloudTools
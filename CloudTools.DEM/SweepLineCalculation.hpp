@@ -2,15 +2,16 @@
 
 #include <string>
 #include <vector>
-#include <cmath>
 #include <functional>
 #include <algorithm>
+#include <mutex>
 #include <stdexcept>
 
 #include <boost/filesystem.hpp>
 
 #include "Calculation.h"
 #include "Window.hpp"
+#include "SweepLineDriver.hpp"
 #include "Metadata.h"
 #include "Helper.h"
 
@@ -23,20 +24,49 @@ namespace DEM
 	/// <summary>
 	/// Represents a sweepline calculation on DEM datasets.
 	/// </summary>
-	template <typename SourceType>
+	/// <remarks>
+	/// The computation type may be any callable with the signature of the default <c>std::function</c> wrapper.
+	/// Using a concrete functor type enables the computation to be inlined into the sweeping loop.
+	/// </remarks>
+	template <typename SourceType,
+	          typename Computation = std::function<void(int, int, const std::vector<Window<SourceType>>&)>>
 	class SweepLineCalculation : public Calculation
 	{
 	public:
-		typedef std::function<void(int, int, const std::vector<Window<SourceType>>&)> ComputationType;
+		typedef Computation ComputationType;
 		ComputationType computation;
 		/// <summary>
 		/// The indices of bands to use respectively for each data source.
 		/// </summary>
 		std::vector<int> bands;
 
+		/// <summary>
+		/// Specifies whether to iterate over the target area by the native blocks of the sources instead of scanlines.
+		/// </summary>
+		/// <remarks>
+		/// The tiles are aligned to the blocks of the first source band. When the sources are
+		/// tiled, each tile (expanded by the range) is read with a single I/O request.
+		/// Falls back to the scanline iteration for stripped sources.
+		/// The computation is called for the positions in tile order in this mode.
+		/// </remarks>
+		bool blockIteration = false;
+
+		/// <summary>
+		/// The number of threads to execute the computation with.
+		/// </summary>
+		/// <remarks>
+		/// With multiple threads the target area is split into horizontal bands (or ranges of tiles), which are
+		/// computed parallelly with separate source dataset handles. The computation method must be thread-safe
+		/// in this mode, see <see cref="SweepLineReduction"/> for accumulating results without locking.
+		/// </remarks>
+		unsigned int threadCount = 1;
+
 	protected:
 		int _range;
 
+	private:
+		SweepLineLayout _layout;
+
 	public:
 		/// <summary>
 		/// Initializes a new instance of the class and loads source metadata.
@@ -98,10 +128,54 @@ namespace DEM
 		/// Executes the computation on the target area.
 		/// </summary>
 		void onExecute() override;
+
+		/// <summary>
+		/// Gets the computation to be performed by a worker.
+		/// </summary>
+		/// <remarks>
+		/// Called on the executing thread for each worker before the computation starts.
+		/// </remarks>
+		/// <param name="worker">The index of the worker, processing the bands in increasing order.</param>
+		/// <param name="workerCount">The number of workers.</param>
+		virtual ComputationType& workerComputation(int worker, int workerCount)
+		{
+			return computation;
+		}
+
+	private:
+		/// <summary>
+		/// Executes the computation on a horizontal band of the target area.
+		/// </summary>
+		/// <param name="compute">The computation to perform.</param>
+		/// <param name="sourceBands">The source bands to read.</param>
+		/// <param name="sourceMutexes">The mutexes guarding the source bands when shared between threads.</param>
+		/// <param name="firstRow">The first row of the band.</param>
+		/// <param name="lastRow">The row after the last row of the band.</param>
+		/// <param name="rowDone">The callback to report a finished row.</param>
+		void computeRows(ComputationType& compute,
+		                 const std::vector<GDALRasterBand*>& sourceBands,
+		                 const std::vector<std::mutex*>& sourceMutexes,
+		                 int firstRow, int lastRow,
+		                 const std::function<void()>& rowDone);
+
+		/// <summary>
+		/// Executes the computation on a range of tiles of the target area.
+		/// </summary>
+		/// <param name="compute">The computation to perform.</param>
+		/// <param name="sourceBands">The source bands to read.</param>
+		/// <param name="sourceMutexes">The mutexes guarding the source bands when shared between threads.</param>
+		/// <param name="firstBlock">The row-major index of the first tile.</param>
+		/// <param name="lastBlock">The index after the last tile.</param>
+		/// <param name="blockDone">The callback to report a finished tile.</param>
+		void computeBlocks(ComputationType& compute,
+		                   const std::vector<GDALRasterBand*>& sourceBands,
+		                   const std::vector<std::mutex*>& sourceMutexes,
+		                   int firstBlock, int lastBlock,
+		                   const std::function<void()>& blockDone);
 	};
 
-	template <typename SourceType>
-	SweepLineCalculation<SourceType>::SweepLineCalculation(
+	template <typename SourceType, typename Computation>
+	SweepLineCalculation<SourceType, Computation>::SweepLineCalculation(
 		const std::vector<std::string>& sourcePaths,
 		int range,
 		ComputationType computation,
@@ -112,8 +186,8 @@ namespace DEM
 		setRange(range);
 	}
 
-	template <typename SourceType>
-	SweepLineCalculation<SourceType>::SweepLineCalculation(
+	template <typename SourceType, typename Computation>
+	SweepLineCalculation<SourceType, Computation>::SweepLineCalculation(
 		const std::vector<GDALDataset*>& sourceDatasets,
 		int range,
 		ComputationType computation,
@@ -124,27 +198,23 @@ namespace DEM
 		setRange(range);
 	}
 
-	template <typename SourceType>
-	void SweepLineCalculation<SourceType>::setRange(int value)
+	template <typename SourceType, typename Computation>
+	void SweepLineCalculation<SourceType, Computation>::setRange(int value)
 	{
 		if (value < 0)
 			throw std::out_of_range("Range must be non-negative.");
 		_range = value;
 	}
 
-	template <typename SourceType>
-	void SweepLineCalculation<SourceType>::onExecute()
+	template <typename SourceType, typename Computation>
+	void SweepLineCalculation<SourceType, Computation>::onExecute()
 	{
-		if (!computation)
+		if (!isDefined(computation))
 			throw std::logic_error("No computation method defined.");
 
-		// Determine computation progress steps
-		int computationSize = _targetMetadata.rasterSizeY();
-		int computationStep = computationSize / 199;
-		int computationProgress = 0;
-
 		// Open and check bands
 		std::vector<GDALRasterBand*> sourceBands(sourceCount());
+		std::vector<int> bandIndexes(sourceCount());
 		for (unsigned int i = 0; i < sourceCount(); ++i)
 		{
 			long long bandIndex;
@@ -160,7 +230,8 @@ namespace DEM
 					? std::count(_sourcePaths.begin(), _sourcePaths.begin() + i, _sourcePaths[i]) + 1
 					: std::count(_sourceDatasets.begin(), _sourceDatasets.begin() + i, _sourceDatasets[i]) + 1;
 			}
-			sourceBands[i] = _sourceDatasets[i]->GetRasterBand(static_cast<int>(bandIndex));
+			bandIndexes[i] = static_cast<int>(bandIndex);
+			sourceBands[i] = _sourceDatasets[i]->GetRasterBand(bandIndexes[i]);
 		}
 
 		GDALDataType sourceType = gdalType<SourceType>();
@@ -171,71 +242,102 @@ namespace DEM
 		}))
 			throw std::domain_error("The data type of a source band does not match with the given data type.");
 
-		// Define windows
-		int windowSize = 2 * _range + 1;
-		std::vector<Window<SourceType>> dataWindows;
-		dataWindows.reserve(sourceCount());
+		// Determine the iteration layout
+		int sourceOffsetX = 0, sourceOffsetY = 0;
+		if (!sourceBands.empty())
+			rasterOffset(_sourceMetadata[0], _targetMetadata, sourceOffsetX, sourceOffsetY);
+		_layout = blockIteration && !sourceBands.empty()
+			? SweepLineLayout(_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY(), sourceBands[0],
+			                  sourceOffsetX, sourceOffsetY)
+			: SweepLineLayout(_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY());
+		auto compute = _layout.tiled() ? &SweepLineCalculation::computeBlocks : &SweepLineCalculation::computeRows;
 
-		// Read sources and execute computation
-		SourceType** sourceScanlines = new SourceType*[sourceCount()];
-		for (unsigned int i = 0; i < sourceCount(); ++i)
-			sourceScanlines[i] = new SourceType[_sourceMetadata[i].rasterSizeX() * windowSize];
+		// Determine computation progress steps
+		int computationSize = _layout.count();
+		SweepLineProgress computationProgress(progress, computationSize);
+		std::function<void()> stepDone = [&computationProgress]() { computationProgress.step(); };
+
+		int workerCount = static_cast<int>(std::min<unsigned int>(
+			std::max(threadCount, 1u), std::max(computationSize, 1)));
+		std::vector<ComputationType*> workerComputations(workerCount);
+		for (int k = 0; k < workerCount; ++k)
+			workerComputations[k] = &workerComputation(k, workerCount);
 
-		for (int y = 0; y < _targetMetadata.rasterSizeY(); ++y)
+		// Compute the horizontal bands (or ranges of tiles) parallelly
+		SweepLineSources sources(_sourceDatasets, bandIndexes, workerCount, SweepLineSources::ReadMode::Sequential,
+			[this](unsigned int index) { return openSourceHandle(index); });
+		runWorkers(computationSize, workerCount, [&](int worker, int first, int last)
 		{
-			CPLErr ioResult = CE_None;
+			(this->*compute)(*workerComputations[worker],
+			                 sources.bands(worker), sources.mutexes(worker),
+			                 first, last, stepDone);
+		});
+	}
 
-			dataWindows.clear();
-			for (unsigned int i = 0; i < sourceCount(); ++i)
-			{
-				int sourceOffsetX = static_cast<int>((_sourceMetadata[i].originX() - _targetMetadata.originX()) / std::abs(_targetMetadata.pixelSizeX()));
-				int sourceOffsetY = static_cast<int>((_targetMetadata.originY() - _sourceMetadata[i].originY()) / std::abs(_targetMetadata.pixelSizeY()));
+	template <typename SourceType, typename Computation>
+	void SweepLineCalculation<SourceType, Computation>::computeRows(
+		ComputationType& compute,
+		const std::vector<GDALRasterBand*>& sourceBands,
+		const std::vector<std::mutex*>& sourceMutexes,
+		int firstRow, int lastRow,
+		const std::function<void()>& rowDone)
+	{
+		// Define windows
+		ScanlineWindows<SourceType> sourceWindows(sourceBands, sourceMutexes, _sourceMetadata, _targetMetadata, _range);
+		std::vector<Window<SourceType>>& dataWindows = sourceWindows.windows();
 
-				if (y + _range >= sourceOffsetY &&
-					y - _range < sourceOffsetY + _sourceMetadata[i].rasterSizeY())
-				{
-					int readOffsetX = 0;
-					int readOffsetY = std::max(0, -sourceOffsetY + y - _range);
-					int readSizeX = _sourceMetadata[i].rasterSizeX();
-					int readSizeY = -readOffsetY + std::min(readOffsetY + windowSize, _sourceMetadata[i].rasterSizeY());
-
-					ioResult = static_cast<CPLErr>(ioResult | 
-						sourceBands[i]->RasterIO(GF_Read,
-							readOffsetX, readOffsetY,
-							readSizeX, readSizeY,
-							sourceScanlines[i], _sourceMetadata[i].rasterSizeX(), windowSize,
-							sourceType, 0, 0));
-
-					dataWindows.emplace_back(sourceScanlines[i], 
-						static_cast<SourceType>(sourceBands[i]->GetNoDataValue()),
-						readSizeX, readSizeY,
-						sourceOffsetX + readOffsetX, sourceOffsetY + readOffsetY,
-						0, y);
-				}
-				else
-					dataWindows.emplace_back(sourceScanlines[i], 
-						static_cast<SourceType>(sourceBands[i]->GetNoDataValue()),
-						0, 0,
-						sourceOffsetX, sourceOffsetY,
-						0, y);
-			}
-			if (ioResult != CE_None)
+		// Read sources and execute computation
+		for (int y = firstRow; y < lastRow; ++y)
+		{
+			if (sourceWindows.fetch(y) != CE_None)
 				throw std::runtime_error("Source read error occured.");
 
 			for (int x = 0; x < _targetMetadata.rasterSizeX(); ++x)
 			{
 				for (Window<SourceType>& window : dataWindows)
 					window.centerX = x;
-				computation(x, y, dataWindows);
+				compute(x, y, dataWindows);
 			}
 
-			if (progress && (computationProgress++ % computationStep == 0 || computationProgress == computationSize))
-				progress(1.f * computationProgress / computationSize, std::string());
+			rowDone();
 		}
+	}
 
-		for (unsigned int i = 0; i < sourceCount(); ++i)
-			delete[] sourceScanlines[i];
-		delete[] sourceScanlines;
+	template <typename SourceType, typename Computation>
+	void SweepLineCalculation<SourceType, Computation>::computeBlocks(
+		ComputationType& compute,
+		const std::vector<GDALRasterBand*>& sourceBands,
+		const std::vector<std::mutex*>& sourceMutexes,
+		int firstBlock, int lastBlock,
+		const std::function<void()>& blockDone)
+	{
+		// Define windows
+		TileWindows<SourceType> sourceWindows(sourceBands, sourceMutexes, _sourceMetadata, _targetMetadata,
+			_range, _layout.blockSizeX(), _layout.blockSizeY());
+		std::vector<Window<SourceType>>& dataWindows = sourceWindows.windows();
+
+		// Read sources and execute computation
+		for (int block = firstBlock; block < lastBlock; ++block)
+		{
+			int blockOffsetX, blockOffsetY, blockSizeX, blockSizeY;
+			_layout.tile(block, blockOffsetX, blockOffsetY, blockSizeX, blockSizeY);
+
+			if (sourceWindows.fetch(blockOffsetX, blockOffsetY, blockSizeX, blockSizeY) != CE_None)
+				throw std::runtime_error("Source read error occured.");
+
+			for (int y = blockOffsetY; y < blockOffsetY + blockSizeY; ++y)
+				for (int x = blockOffsetX; x < blockOffsetX + blockSizeX; ++x)
+				{
+					for (Window<SourceType>& window : dataWindows)
+					{
+						window.centerX = x;
+						window.centerY = y;
+					}
+					compute(x, y, dataWindows);
+				}
+
+			blockDone();
+		}
 	}
 } // DEM
 } // CloudTools
@@ -0,0 +1,619 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <exception>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include <CloudTools.Common/Operation.h>
+#include "Window.hpp"
+#include "ScanlineCache.hpp"
+#include "BlockBuffer.hpp"
+#include "ValidityMask.hpp"
+#include "Quantization.hpp"
+#include "Metadata.h"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Computes the offset of a source raster in pixels of the target raster.
+/// </summary>
+/// <param name="source">The metadata of the source raster.</param>
+/// <param name="target">The metadata of the target raster.</param>
+/// <param name="offsetX">The abcissa offset of the source.</param>
+/// <param name="offsetY">The ordinate offset of the source.</param>
+inline void rasterOffset(const RasterMetadata& source, const RasterMetadata& target, int& offsetX, int& offsetY)
+{
+	offsetX = static_cast<int>((source.originX() - target.originX()) / std::abs(target.pixelSizeX()));
+	offsetY = static_cast<int>((target.originY() - source.originY()) / std::abs(target.pixelSizeY()));
+}
+
+/// <summary>
+/// Represents the iteration layout of a sweepline operation: the scanlines or the tiles of the target.
+/// </summary>
+class SweepLineLayout
+{
+private:
+	int _sizeX;
+	int _sizeY;
+	int _blockSizeX;
+	int _blockSizeY;
+	int _shiftX;
+	int _shiftY;
+	int _blockCountX;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class iterating by scanlines.
+	/// </summary>
+	/// <param name="sizeX">The width of the target.</param>
+	/// <param name="sizeY">The height of the target.</param>
+	SweepLineLayout(int sizeX = 0, int sizeY = 0)
+		: _sizeX(sizeX), _sizeY(sizeY),
+		  _blockSizeX(std::max(sizeX, 1)), _blockSizeY(1),
+		  _shiftX(0), _shiftY(0), _blockCountX(1)
+	{ }
+
+	/// <summary>
+	/// Initializes a new instance of the class iterating by the native blocks of a band.
+	/// </summary>
+	/// <remarks>
+	/// The tiles are aligned to the blocks of the band, so the tiles on the top and left edges of the target
+	/// might be smaller when the band is offset from the target.
+	/// Falls back to the scanline iteration if the band is stripped.
+	/// </remarks>
+	/// <param name="sizeX">The width of the target.</param>
+	/// <param name="sizeY">The height of the target.</param>
+	/// <param name="band">The band defining the tiles.</param>
+	/// <param name="bandOffsetX">The abcissa offset of the band in the target.</param>
+	/// <param name="bandOffsetY">The ordinate offset of the band in the target.</param>
+	SweepLineLayout(int sizeX, int sizeY, GDALRasterBand* band, int bandOffsetX, int bandOffsetY)
+		: SweepLineLayout(sizeX, sizeY)
+	{
+		int blockSizeX, blockSizeY;
+		band->GetBlockSize(&blockSizeX, &blockSizeY);
+		if (blockSizeX > 0 && blockSizeY > 0 && blockSizeX < sizeX)
+		{
+			_blockSizeX = blockSizeX;
+			_blockSizeY = blockSizeY;
+
+			// The block boundaries of the band in the target are shifted by the offset of the band
+			_shiftX = (bandOffsetX % blockSizeX + blockSizeX) % blockSizeX;
+			_shiftY = (bandOffsetY % blockSizeY + blockSizeY) % blockSizeY;
+			if (_shiftX > 0)
+				_shiftX -= blockSizeX;
+			if (_shiftY > 0)
+				_shiftY -= blockSizeY;
+			_blockCountX = (sizeX - _shiftX + blockSizeX - 1) / blockSizeX;
+		}
+	}
+
+	/// <summary>
+	/// Gets whether the target is iterated by tiles.
+	/// </summary>
+	bool tiled() const { return _blockSizeX < _sizeX; }
+
+	/// <summary>
+	/// Gets the maximal width of a tile.
+	/// </summary>
+	int blockSizeX() const { return _blockSizeX; }
+
+	/// <summary>
+	/// Gets the maximal height of a tile.
+	/// </summary>
+	int blockSizeY() const { return _blockSizeY; }
+
+	/// <summary>
+	/// Gets the number of iteration steps: scanlines or tiles.
+	/// </summary>
+	int count() const
+	{
+		return tiled() ? _blockCountX * ((_sizeY - _shiftY + _blockSizeY - 1) / _blockSizeY) : _sizeY;
+	}
+
+	/// <summary>
+	/// Retrieves the area of a tile.
+	/// </summary>
+	/// <param name="index">The row-major index of the tile.</param>
+	/// <param name="offsetX">The abcissa offset of the tile.</param>
+	/// <param name="offsetY">The ordinate offset of the tile.</param>
+	/// <param name="sizeX">The width of the tile.</param>
+	/// <param name="sizeY">The height of the tile.</param>
+	void tile(int index, int& offsetX, int& offsetY, int& sizeX, int& sizeY) const
+	{
+		int blockOffsetX = _shiftX + (index % _blockCountX) * _blockSizeX;
+		int blockOffsetY = _shiftY + (index / _blockCountX) * _blockSizeY;
+		offsetX = std::max(blockOffsetX, 0);
+		offsetY = std::max(blockOffsetY, 0);
+		sizeX = std::min(blockOffsetX + _blockSizeX, _sizeX) - offsetX;
+		sizeY = std::min(blockOffsetY + _blockSizeY, _sizeY) - offsetY;
+	}
+};
+
+/// <summary>
+/// Represents the counter of the finished steps of a sweepline operation, reporting the progress.
+/// </summary>
+/// <remarks>
+/// The steps might be finished concurrently by multiple workers.
+/// </remarks>
+class SweepLineProgress
+{
+private:
+	Operation::ProgressType _progress;
+	int _size;
+	int _step;
+	std::atomic<int> _done;
+	std::mutex _mutex;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="progress">The callback method to report progress.</param>
+	/// <param name="size">The number of steps.</param>
+	SweepLineProgress(const Operation::ProgressType& progress, int size)
+		: _progress(progress), _size(size), _step(std::max(size / 199, 1)), _done(0)
+	{ }
+
+	SweepLineProgress(const SweepLineProgress&) = delete;
+	SweepLineProgress& operator=(const SweepLineProgress&) = delete;
+
+	/// <summary>
+	/// Reports a finished step.
+	/// </summary>
+	void step()
+	{
+		int done = ++_done;
+		if (_progress && (done % _step == 0 || done == _size))
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_progress(1.f * done / _size, std::string());
+		}
+	}
+};
+
+/// <summary>
+/// Represents the source band handles of the workers of a parallel sweepline operation.
+/// </summary>
+/// <remarks>
+/// The first worker reads the original datasets, the others separate handles if the datasets can be reopened.
+/// The handles shared between threads are guarded by a mutex per handle, as multiple sources might read the same one.
+/// </remarks>
+class SweepLineSources
+{
+public:
+	/// <summary>
+	/// The callback function opening a separate handle of a source dataset, <c>nullptr</c> if not possible.
+	/// </summary>
+	typedef std::function<GDALDataset*(unsigned int)> OpenType;
+
+	/// <summary>
+	/// Specifies the threads reading the sources of a worker.
+	/// </summary>
+	enum class ReadMode
+	{
+		/// <summary>
+		/// The sources are read by the worker sequentially.
+		/// </summary>
+		Sequential,
+		/// <summary>
+		/// Each source is read by a separate thread, so the sources sharing a handle are guarded as well.
+		/// </summary>
+		Concurrent,
+		/// <summary>
+		/// The sources are read by any number of threads, so all handles are guarded.
+		/// </summary>
+		Shared
+	};
+
+private:
+	std::vector<GDALDataset*> _handles;
+	std::vector<std::vector<GDALRasterBand*>> _bands;
+	std::vector<std::vector<std::mutex*>> _mutexes;
+	std::map<GDALDataset*, std::unique_ptr<std::mutex>> _sharedMutexes;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class and opens the handles of the workers.
+	/// </summary>
+	/// <param name="datasets">The source datasets.</param>
+	/// <param name="bandIndexes">The indices of the bands to read respectively for each source.</param>
+	/// <param name="workerCount">The number of workers.</param>
+	/// <param name="mode">Specifies the threads reading the sources of a worker.</param>
+	/// <param name="open">The callback function opening a separate handle of a source dataset.</param>
+	SweepLineSources(const std::vector<GDALDataset*>& datasets,
+	                 const std::vector<int>& bandIndexes,
+	                 int workerCount, ReadMode mode,
+	                 const OpenType& open);
+
+	SweepLineSources(const SweepLineSources&) = delete;
+	SweepLineSources& operator=(const SweepLineSources&) = delete;
+
+	~SweepLineSources()
+	{
+		for (GDALDataset* handle : _handles)
+			GDALClose(handle);
+	}
+
+	/// <summary>
+	/// Gets the source bands of a worker.
+	/// </summary>
+	const std::vector<GDALRasterBand*>& bands(int worker) const { return _bands.at(worker); }
+
+	/// <summary>
+	/// Gets the mutexes guarding the source bands of a worker, <c>nullptr</c> when not shared.
+	/// </summary>
+	const std::vector<std::mutex*>& mutexes(int worker) const { return _mutexes.at(worker); }
+};
+
+inline SweepLineSources::SweepLineSources(const std::vector<GDALDataset*>& datasets,
+                                          const std::vector<int>& bandIndexes,
+                                          int workerCount, ReadMode mode,
+                                          const OpenType& open)
+	: _bands(workerCount), _mutexes(workerCount, std::vector<std::mutex*>(datasets.size(), nullptr))
+{
+	if (workerCount > 1)
+		for (GDALDataset* dataset : datasets)
+			dataset->FlushCache();
+
+	// Sources of the same dataset share the handle of the worker
+	std::vector<std::vector<GDALDataset*>> workerHandles(workerCount, datasets);
+	for (int k = 1; k < workerCount; ++k)
+	{
+		std::map<GDALDataset*, GDALDataset*> reopened;
+		for (unsigned int i = 0; i < datasets.size(); ++i)
+		{
+			auto handle = reopened.find(datasets[i]);
+			if (handle == reopened.end())
+			{
+				handle = reopened.emplace(datasets[i], open(i)).first;
+				if (handle->second != nullptr)
+					_handles.push_back(handle->second);
+			}
+			if (handle->second != nullptr)
+				workerHandles[k][i] = handle->second;
+		}
+	}
+
+	// Guard the handles accessed by multiple threads
+	std::map<GDALDataset*, std::vector<int>> users;
+	for (int k = 0; k < workerCount; ++k)
+		for (GDALDataset* handle : workerHandles[k])
+			users[handle].push_back(k);
+	for (auto& user : users)
+		if (mode == ReadMode::Shared ||
+			(mode == ReadMode::Concurrent && user.second.size() > 1) ||
+			user.second.front() != user.second.back())
+			_sharedMutexes[user.first].reset(new std::mutex());
+
+	for (int k = 0; k < workerCount; ++k)
+		for (unsigned int i = 0; i < datasets.size(); ++i)
+		{
+			GDALDataset* handle = workerHandles[k][i];
+			_bands[k].push_back(handle->GetRasterBand(bandIndexes[i]));
+			auto mutex = _sharedMutexes.find(handle);
+			if (mutex != _sharedMutexes.end())
+				_mutexes[k][i] = mutex->second.get();
+		}
+}
+
+/// <summary>
+/// Executes the parts of a sweepline operation parallelly.
+/// </summary>
+/// <remarks>
+/// The steps are split into consecutive ranges, one for each worker. A single worker is executed on the calling thread.
+/// The first failure of the workers is rethrown after all of them finished.
+/// </remarks>
+/// <param name="size">The number of steps.</param>
+/// <param name="workerCount">The number of workers.</param>
+/// <param name="work">The callback function executing the steps <c>[first, last)</c> by a worker.</param>
+inline void runWorkers(int size, int workerCount, const std::function<void(int, int, int)>& work)
+{
+	if (workerCount == 1)
+	{
+		work(0, 0, size);
+		return;
+	}
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(workerCount);
+	for (int k = 0; k < workerCount; ++k)
+	{
+		int first = static_cast<int>(1LL * size * k / workerCount);
+		int last = static_cast<int>(1LL * size * (k + 1) / workerCount);
+		futures.push_back(std::async(std::launch::async, work, k, first, last));
+	}
+
+	std::exception_ptr error;
+	for (auto& future : futures)
+	{
+		try
+		{
+			future.get();
+		}
+		catch (...)
+		{
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+/// <summary>
+/// Represents the source windows of a sweepline operation advancing by the scanlines of the target.
+/// </summary>
+/// <remarks>
+/// Only the scanlines entering the windows are read, the others are reused.
+/// </remarks>
+template <typename DataType>
+class ScanlineWindows
+{
+private:
+	int _range;
+	int _targetSizeX;
+	std::vector<int> _offsetX;
+	std::vector<int> _offsetY;
+	std::vector<int> _sizeX;
+	std::vector<int> _sizeY;
+	std::vector<DataType> _nodataValues;
+	std::vector<std::unique_ptr<ScanlineCache<DataType>>> _caches;
+	std::vector<Window<DataType>> _windows;
+	int _row;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="bands">The source bands to read.</param>
+	/// <param name="mutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	/// <param name="sourceMetadata">The metadata of the sources.</param>
+	/// <param name="targetMetadata">The metadata of the target.</param>
+	/// <param name="range">The range of surrounding data to involve in the windows.</param>
+	ScanlineWindows(const std::vector<GDALRasterBand*>& bands,
+	                const std::vector<std::mutex*>& mutexes,
+	                const std::vector<RasterMetadata>& sourceMetadata,
+	                const RasterMetadata& targetMetadata,
+	                int range);
+
+	ScanlineWindows(const ScanlineWindows&) = delete;
+	ScanlineWindows& operator=(const ScanlineWindows&) = delete;
+
+	/// <summary>
+	/// Starts reading ahead the scanlines of the sources required for the given target rows in the background.
+	/// </summary>
+	/// <param name="firstRow">The first target row to compute.</param>
+	/// <param name="lastRow">The row after the last target row to compute.</param>
+	/// <param name="depth">The maximal number of scanlines to read ahead.</param>
+	void prefetch(int firstRow, int lastRow, int depth);
+
+	/// <summary>
+	/// Advances the windows to a target row.
+	/// </summary>
+	/// <param name="row">The index of the target row, must be increasing.</param>
+	/// <returns>The result of the raster I/O operations.</returns>
+	CPLErr fetch(int row);
+
+	/// <summary>
+	/// Gets the windows of the sources in the current target row.
+	/// </summary>
+	std::vector<Window<DataType>>& windows() { return _windows; }
+
+	/// <summary>
+	/// Collects the runs of the current target row whose window contains valid data of the first source.
+	/// </summary>
+	/// <param name="runs">The target of the runs.</param>
+	void occupancy(std::vector<ValidityRun>& runs) const;
+
+private:
+	/// <summary>
+	/// Determines whether the window of a source intersects the source in the current target row.
+	/// </summary>
+	bool covers(std::size_t index) const
+	{
+		return _row + _range >= _offsetY[index] &&
+		       _row - _range < _offsetY[index] + _sizeY[index];
+	}
+};
+
+template <typename DataType>
+ScanlineWindows<DataType>::ScanlineWindows(const std::vector<GDALRasterBand*>& bands,
+                                           const std::vector<std::mutex*>& mutexes,
+                                           const std::vector<RasterMetadata>& sourceMetadata,
+                                           const RasterMetadata& targetMetadata,
+                                           int range)
+	: _range(range), _targetSizeX(targetMetadata.rasterSizeX()),
+	  _offsetX(bands.size()), _offsetY(bands.size()),
+	  _sizeX(bands.size()), _sizeY(bands.size()),
+	  _nodataValues(bands.size()), _row(0)
+{
+	_caches.reserve(bands.size());
+	_windows.reserve(bands.size());
+	for (std::size_t i = 0; i < bands.size(); ++i)
+	{
+		rasterOffset(sourceMetadata[i], targetMetadata, _offsetX[i], _offsetY[i]);
+		_sizeX[i] = sourceMetadata[i].rasterSizeX();
+		_sizeY[i] = sourceMetadata[i].rasterSizeY();
+		_nodataValues[i] = static_cast<DataType>(Quantization::nodataValue(bands[i]));
+		_caches.emplace_back(new ScanlineCache<DataType>(bands[i], 2 * range + 1, mutexes[i]));
+	}
+}
+
+template <typename DataType>
+void ScanlineWindows<DataType>::prefetch(int firstRow, int lastRow, int depth)
+{
+	for (std::size_t i = 0; i < _caches.size(); ++i)
+		_caches[i]->prefetch(
+			std::max(0, firstRow - _offsetY[i] - _range),
+			std::min(_sizeY[i], lastRow - _offsetY[i] + _range),
+			depth);
+}
+
+template <typename DataType>
+CPLErr ScanlineWindows<DataType>::fetch(int row)
+{
+	CPLErr ioResult = CE_None;
+	_row = row;
+
+	_windows.clear();
+	for (std::size_t i = 0; i < _caches.size(); ++i)
+	{
+		if (covers(i))
+		{
+			int readOffsetY = std::max(0, -_offsetY[i] + row - _range);
+			int readSizeY = -readOffsetY + std::min(-_offsetY[i] + row + _range + 1, _sizeY[i]);
+
+			ioResult = static_cast<CPLErr>(ioResult |
+				_caches[i]->fetch(readOffsetY, readSizeY));
+
+			_windows.emplace_back(_caches[i]->rows(),
+				_nodataValues[i],
+				_sizeX[i], readSizeY,
+				_offsetX[i], _offsetY[i] + readOffsetY,
+				0, row,
+				_caches[i]->validity());
+		}
+		else
+			_windows.emplace_back(nullptr,
+				_nodataValues[i],
+				0, 0,
+				_offsetX[i], _offsetY[i],
+				0, row);
+	}
+	return ioResult;
+}
+
+template <typename DataType>
+void ScanlineWindows<DataType>::occupancy(std::vector<ValidityRun>& runs) const
+{
+	runs.clear();
+	if (!_caches.empty() && covers(0))
+		collectValidityRuns(_caches[0]->validity(), _caches[0]->rowCount(),
+			_sizeX[0], _range, _offsetX[0], _targetSizeX, runs);
+}
+
+/// <summary>
+/// Represents the source windows of a sweepline operation iterating over the tiles of the target.
+/// </summary>
+/// <remarks>
+/// Each tile expanded by the range and clipped to the source is read with a single I/O request.
+/// </remarks>
+template <typename DataType>
+class TileWindows
+{
+private:
+	int _range;
+	std::vector<int> _offsetX;
+	std::vector<int> _offsetY;
+	std::vector<int> _sizeX;
+	std::vector<int> _sizeY;
+	std::vector<std::unique_ptr<BlockBuffer<DataType>>> _buffers;
+	std::vector<Window<DataType>> _windows;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="bands">The source bands to read.</param>
+	/// <param name="mutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	/// <param name="sourceMetadata">The metadata of the sources.</param>
+	/// <param name="targetMetadata">The metadata of the target.</param>
+	/// <param name="range">The range of surrounding data to involve in the windows.</param>
+	/// <param name="tileSizeX">The maximal width of the tiles.</param>
+	/// <param name="tileSizeY">The maximal height of the tiles.</param>
+	TileWindows(const std::vector<GDALRasterBand*>& bands,
+	            const std::vector<std::mutex*>& mutexes,
+	            const std::vector<RasterMetadata>& sourceMetadata,
+	            const RasterMetadata& targetMetadata,
+	            int range, int tileSizeX, int tileSizeY);
+
+	TileWindows(const TileWindows&) = delete;
+	TileWindows& operator=(const TileWindows&) = delete;
+
+	/// <summary>
+	/// Reads the sources for a target tile.
+	/// </summary>
+	/// <param name="tileOffsetX">The abcissa offset of the tile.</param>
+	/// <param name="tileOffsetY">The ordinate offset of the tile.</param>
+	/// <param name="tileSizeX">The width of the tile.</param>
+	/// <param name="tileSizeY">The height of the tile.</param>
+	/// <returns>The result of the raster I/O operations.</returns>
+	CPLErr fetch(int tileOffsetX, int tileOffsetY, int tileSizeX, int tileSizeY);
+
+	/// <summary>
+	/// Gets the windows of the sources in the current tile.
+	/// </summary>
+	std::vector<Window<DataType>>& windows() { return _windows; }
+};
+
+template <typename DataType>
+TileWindows<DataType>::TileWindows(const std::vector<GDALRasterBand*>& bands,
+                                   const std::vector<std::mutex*>& mutexes,
+                                   const std::vector<RasterMetadata>& sourceMetadata,
+                                   const RasterMetadata& targetMetadata,
+                                   int range, int tileSizeX, int tileSizeY)
+	: _range(range),
+	  _offsetX(bands.size()), _offsetY(bands.size()),
+	  _sizeX(bands.size()), _sizeY(bands.size())
+{
+	_buffers.reserve(bands.size());
+	_windows.reserve(bands.size());
+	for (std::size_t i = 0; i < bands.size(); ++i)
+	{
+		rasterOffset(sourceMetadata[i], targetMetadata, _offsetX[i], _offsetY[i]);
+		_sizeX[i] = sourceMetadata[i].rasterSizeX();
+		_sizeY[i] = sourceMetadata[i].rasterSizeY();
+		_buffers.emplace_back(new BlockBuffer<DataType>(bands[i],
+			tileSizeX + 2 * range, tileSizeY + 2 * range, mutexes[i]));
+	}
+}
+
+template <typename DataType>
+CPLErr TileWindows<DataType>::fetch(int tileOffsetX, int tileOffsetY, int tileSizeX, int tileSizeY)
+{
+	CPLErr ioResult = CE_None;
+
+	_windows.clear();
+	for (std::size_t i = 0; i < _buffers.size(); ++i)
+	{
+		int readOffsetX = std::max(0, -_offsetX[i] + tileOffsetX - _range);
+		int readSizeX = -readOffsetX + std::min(-_offsetX[i] + tileOffsetX + tileSizeX + _range, _sizeX[i]);
+		int readOffsetY = std::max(0, -_offsetY[i] + tileOffsetY - _range);
+		int readSizeY = -readOffsetY + std::min(-_offsetY[i] + tileOffsetY + tileSizeY + _range, _sizeY[i]);
+
+		if (readSizeX > 0 && readSizeY > 0)
+		{
+			ioResult = static_cast<CPLErr>(ioResult |
+				_buffers[i]->fetch(readOffsetX, readOffsetY, readSizeX, readSizeY));
+
+			_windows.emplace_back(_buffers[i]->rows(),
+				_buffers[i]->nodataValue(),
+				readSizeX, readSizeY,
+				_offsetX[i] + readOffsetX, _offsetY[i] + readOffsetY,
+				tileOffsetX, tileOffsetY,
+				_buffers[i]->validity());
+		}
+		else
+			_windows.emplace_back(nullptr,
+				_buffers[i]->nodataValue(),
+				0, 0,
+				_offsetX[i], _offsetY[i],
+				tileOffsetX, tileOffsetY);
+	}
+	return ioResult;
+}
+} // DEM
+} // CloudTools
@@ -0,0 +1,608 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include <boost/filesystem.hpp>
+
+#include "Transformation.h"
+#include "SweepLineTransformation.hpp"
+#include "Window.hpp"
+#include "RowWindow.hpp"
+#include "Metadata.h"
+#include "Helper.h"
+
+namespace fs = boost::filesystem;
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a pipeline of sweepline transformations on DEM datasets, computed in a single streaming pass.
+/// </summary>
+/// <remarks>
+/// Each stage reads the result of the previous stage (the first stage reads the sources).
+/// The intermediate results are not materialized: a stage computes its rows on demand
+/// and only the halo rows required by the range of the next stage are kept in memory.
+/// Operations requiring the whole intermediate result (e.g. a sieve filter) can be inserted
+/// as barriers: the preceding stages are materialized into an in-memory dataset,
+/// which is then transformed by the barrier and read by the subsequent stages.
+/// The result of a stage can also be persisted with a sink, e.g. for debugging. A barrier materializes
+/// the result of the preceding stage into its sink if given, otherwise in memory.
+/// Sparse stages only compute the neighborhood of the valid data of their source, so the stages following
+/// a selective one (e.g. thresholding) are nearly free on mostly empty rasters.
+/// The progress is reported with the messages of the stages currently computed.
+/// </remarks>
+template <typename DataType = float>
+class SweepLinePipeline : public Transformation
+{
+public:
+	typedef std::function<DataType(int, int, const std::vector<Window<DataType>>&)> ComputationType;
+	typedef std::function<void(int, const std::vector<RowWindow<DataType>>&, DataType*)> RowComputationType;
+	/// <summary>
+	/// The callback function of a barrier, producing a new dataset from the materialized intermediate result.
+	/// </summary>
+	/// <remarks>
+	/// The returned dataset is owned and closed by the pipeline.
+	/// </remarks>
+	typedef std::function<GDALDataset*(GDALDataset*)> BarrierType;
+
+	/// <summary>
+	/// The indices of bands to use respectively for each data source.
+	/// </summary>
+	std::vector<int> bands;
+
+	/// <summary>
+	/// The quantization of the intermediate results materialized before the barriers, disabled by default.
+	/// </summary>
+	/// <remarks>
+	/// Unlike <see cref="quantization"/>, the target of the pipeline is not affected.
+	/// </remarks>
+	Quantization intermediateQuantization;
+
+private:
+	/// <summary>
+	/// Represents a stage of the pipeline: a computation or a barrier.
+	/// </summary>
+	struct Stage
+	{
+		int range;
+		ComputationType computation;
+		RowComputationType rowComputation;
+		DataType nodataValue;
+		BarrierType barrier;
+		bool columnStatistics;
+		bool sparse;
+		std::string message;
+		bool sink;
+		std::string sinkPath;
+	};
+
+	/// <summary>
+	/// Computes the rows of a stage on demand from its row window caches.
+	/// </summary>
+	class StageRunner
+	{
+	private:
+		const Stage& _stage;
+		int _sizeX;
+		std::vector<std::unique_ptr<RowWindowCache<DataType>>> _caches;
+		std::vector<DataType> _nodataValues;
+		std::vector<Window<DataType>> _windows;
+		std::vector<RowWindow<DataType>> _rowWindows;
+		std::vector<ValidityRun> _runs;
+		GDALRasterBand* _sinkBand;
+
+	public:
+		StageRunner(const Stage& stage, int sizeX)
+			: _stage(stage), _sizeX(sizeX), _sinkBand(nullptr)
+		{ }
+
+		StageRunner(const StageRunner&) = delete;
+		StageRunner& operator=(const StageRunner&) = delete;
+
+		DataType nodataValue() const { return _stage.nodataValue; }
+
+		void addSource(GDALRasterBand* band, int offsetX, int offsetY)
+		{
+			DataType nodataValue = static_cast<DataType>(Quantization::nodataValue(band));
+			_caches.emplace_back(new RowWindowCache<DataType>(band,
+				_sizeX, _stage.range, offsetX, offsetY, nodataValue));
+			_caches.back()->setColumnStatistics(_stage.columnStatistics);
+			_nodataValues.push_back(nodataValue);
+		}
+
+		void addSource(StageRunner& previous, int sizeY)
+		{
+			_caches.emplace_back(new RowWindowCache<DataType>(
+				[&previous](int row, DataType* data) { previous.compute(row, data); },
+				_sizeX, sizeY, _stage.range, previous.nodataValue()));
+			_caches.back()->setColumnStatistics(_stage.columnStatistics);
+			_nodataValues.push_back(previous.nodataValue());
+		}
+
+		void setSink(GDALRasterBand* band)
+		{
+			_sinkBand = band;
+		}
+
+		void compute(int y, DataType* target)
+		{
+			computeRow(y, target);
+			if (_sinkBand != nullptr &&
+				_sinkBand->RasterIO(GF_Write,
+					0, y,
+					_sizeX, 1,
+					target, _sizeX, 1,
+					gdalType<DataType>(), 0, 0) != CE_None)
+				throw std::runtime_error("Stage result write error occured.");
+		}
+
+	private:
+		void computeRow(int y, DataType* target)
+		{
+			CPLErr ioResult = CE_None;
+			for (auto& cache : _caches)
+				ioResult = static_cast<CPLErr>(ioResult | cache->fetch(y));
+			if (ioResult != CE_None)
+				throw std::runtime_error("Source read error occured.");
+
+			// Sparse stages only compute the runs around the valid data of their first source
+			if (_stage.sparse && !_caches.empty())
+			{
+				_caches[0]->occupancy(_runs);
+				if (_runs.empty())
+				{
+					std::fill(target, target + _sizeX, _stage.nodataValue);
+					return;
+				}
+			}
+
+			if (_stage.rowComputation)
+			{
+				_rowWindows.clear();
+				for (auto& cache : _caches)
+					_rowWindows.push_back(cache->window());
+				_stage.rowComputation(y, _rowWindows, target);
+				return;
+			}
+
+			_windows.clear();
+			for (std::size_t i = 0; i < _caches.size(); ++i)
+				_windows.emplace_back(_caches[i]->rows(), _nodataValues[i],
+					_sizeX, 2 * _stage.range + 1,
+					0, y - _stage.range,
+					0, y,
+					_caches[i]->validity());
+			if (_stage.sparse && !_caches.empty())
+				std::fill(target, target + _sizeX, _stage.nodataValue);
+			else
+				_runs.assign(1, ValidityRun{ 0, _sizeX });
+
+			for (const ValidityRun& run : _runs)
+				for (int x = run.begin; x < run.end; ++x)
+				{
+					for (Window<DataType>& window : _windows)
+						window.centerX = x;
+					target[x] = _stage.computation(x, y, _windows);
+				}
+		}
+	};
+
+	std::vector<Stage> _stages;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class and loads source metadata.
+	/// </summary>
+	/// <param name="sourcePaths">The source files of the pipeline.</param>
+	/// <param name="targetPath">The target file of the pipeline.</param>
+	/// <param name="progress">The callback method to report progress.</param>
+	SweepLinePipeline(const std::vector<std::string>& sourcePaths,
+	                  const std::string& targetPath,
+	                  ProgressType progress = nullptr)
+		: Transformation(sourcePaths, targetPath, progress)
+	{ }
+
+	/// <summary>
+	/// Initializes a new instance of the class and loads source metadata.
+	/// </summary>
+	/// <param name="sourceDatasets">The source datasets of the pipeline.</param>
+	/// <param name="targetPath">The target file of the pipeline.</param>
+	/// <param name="progress">The callback method to report progress.</param>
+	SweepLinePipeline(const std::vector<GDALDataset*>& sourceDatasets,
+	                  const std::string& targetPath,
+	                  ProgressType progress = nullptr)
+		: Transformation(sourceDatasets, targetPath, progress)
+	{ }
+
+	SweepLinePipeline(const SweepLinePipeline&) = delete;
+	SweepLinePipeline& operator=(const SweepLinePipeline&) = delete;
+
+	/// <summary>
+	/// Appends a stage computing the target position by position.
+	/// </summary>
+	/// <param name="range">The range of surrounding data to involve in the computations.</param>
+	/// <param name="computation">The callback function for computation.</param>
+	/// <param name="nodataValue">The nodata value of the stage result.</param>
+	/// <param name="sparse">Specifies whether to compute only the positions around the valid data of the stage source.</param>
+	/// <param name="message">The progress message of the stage.</param>
+	void addStage(int range, ComputationType computation, double nodataValue, bool sparse = false,
+	              const std::string& message = std::string())
+	{
+		if (range < 0)
+			throw std::out_of_range("Range must be non-negative.");
+		if (!computation)
+			throw std::logic_error("No computation method defined.");
+		_stages.push_back(Stage{ range, computation, nullptr, static_cast<DataType>(nodataValue), nullptr, false, sparse, message,
+		                         false, std::string() });
+	}
+
+	/// <summary>
+	/// Appends a stage computing the target row by row.
+	/// </summary>
+	/// <param name="range">The range of surrounding data to involve in the computations.</param>
+	/// <param name="rowComputation">The callback function for computing a whole target row.</param>
+	/// <param name="nodataValue">The nodata value of the stage result.</param>
+	/// <param name="columnStatistics">Specifies whether to maintain the column statistics of the row windows.</param>
+	/// <param name="sparse">Specifies whether to skip the rows without valid data around them in the stage source.</param>
+	/// <param name="message">The progress message of the stage.</param>
+	void addStage(int range, RowComputationType rowComputation, double nodataValue,
+	              bool columnStatistics = false, bool sparse = false,
+	              const std::string& message = std::string())
+	{
+		if (range < 0)
+			throw std::out_of_range("Range must be non-negative.");
+		if (!rowComputation)
+			throw std::logic_error("No computation method defined.");
+		_stages.push_back(Stage{ range, nullptr, rowComputation, static_cast<DataType>(nodataValue), nullptr,
+		                         columnStatistics, sparse, message, false, std::string() });
+	}
+
+	/// <summary>
+	/// Appends a stage performing the computation of a sweepline transformation.
+	/// </summary>
+	/// <remarks>
+	/// The range, the computation, the nodata value and the sparsity of the operation are used,
+	/// its sources and target are ignored. The computation of the operation might
+	/// refer to the operation itself, therefore it must outlive the execution of the pipeline.
+	/// </remarks>
+	/// <param name="operation">The sweepline transformation.</param>
+	/// <param name="message">The progress message of the stage.</param>
+	template <typename Computation>
+	void addStage(const SweepLineTransformation<DataType, DataType, Computation>& operation,
+	              const std::string& message = std::string())
+	{
+		if (operation.rowComputation)
+			addStage(operation.range(), operation.rowComputation, operation.nodataValue,
+			         operation.columnStatistics, operation.sparse, message);
+		else if (isDefined(operation.computation))
+			addStage(operation.range(), ComputationType(operation.computation), operation.nodataValue,
+			         operation.sparse, message);
+		else
+			throw std::logic_error("No computation method defined.");
+	}
+
+	/// <summary>
+	/// Appends a barrier, which requires the whole result of the preceding stages.
+	/// </summary>
+	/// <param name="barrier">The callback function transforming the materialized result.</param>
+	/// <param name="message">The progress message of the barrier.</param>
+	void addBarrier(BarrierType barrier, const std::string& message = std::string())
+	{
+		if (!barrier)
+			throw std::logic_error("No barrier method defined.");
+		_stages.push_back(Stage{ 0, nullptr, nullptr, 0, barrier, false, false, message, false, std::string() });
+	}
+
+	/// <summary>
+	/// Persists the result of the last appended stage, e.g. for debugging.
+	/// </summary>
+	/// <remarks>
+	/// The sink is created with the target format and creation options. The result of the last stage
+	/// of the pipeline is its target, hence it cannot have a sink.
+	/// </remarks>
+	/// <param name="path">The path of the sink (empty for in-memory formats).</param>
+	void addSink(const std::string& path)
+	{
+		if (_stages.empty() || _stages.back().barrier)
+			throw std::logic_error("A sink must follow a computation stage.");
+		_stages.back().sink = true;
+		_stages.back().sinkPath = path;
+	}
+
+protected:
+	/// <summary>
+	/// Produces the target file.
+	/// </summary>
+	void onExecute() override;
+
+private:
+	/// <summary>
+	/// Creates a single band dataset with the target metadata.
+	/// </summary>
+	/// <param name="driver">The driver to create the dataset with.</param>
+	/// <param name="path">The path of the dataset.</param>
+	/// <param name="options">The creation options.</param>
+	/// <param name="nodataValue">The nodata value of the band.</param>
+	/// <param name="dataQuantization">The quantization of the band.</param>
+	GDALDataset* createDataset(GDALDriver* driver, const std::string& path,
+	                           const std::map<std::string, std::string>& options,
+	                           double nodataValue, const Quantization& dataQuantization) const;
+
+	/// <summary>
+	/// Creates the dataset of a sink with the target format and creation options.
+	/// </summary>
+	/// <param name="path">The path of the sink.</param>
+	/// <param name="nodataValue">The nodata value of the band.</param>
+	/// <param name="dataQuantization">The quantization of the band.</param>
+	GDALDataset* createSink(const std::string& path, double nodataValue, const Quantization& dataQuantization) const;
+
+	/// <summary>
+	/// Computes the stages of a segment between barriers in a single pass.
+	/// </summary>
+	/// <param name="sourceBands">The source bands of the first stage.</param>
+	/// <param name="sourceMetadata">The metadata of the source bands.</param>
+	/// <param name="firstStage">The index of the first stage of the segment.</param>
+	/// <param name="lastStage">The index after the last stage of the segment.</param>
+	/// <param name="targetBand">The band to write the result of the segment to.</param>
+	/// <param name="targetQuantization">The quantization of the target band.</param>
+	/// <param name="segment">The index of the segment.</param>
+	/// <param name="segmentCount">The number of segments.</param>
+	void computeSegment(const std::vector<GDALRasterBand*>& sourceBands,
+	                    const std::vector<RasterMetadata>& sourceMetadata,
+	                    std::size_t firstStage, std::size_t lastStage,
+	                    GDALRasterBand* targetBand, const Quantization& targetQuantization,
+	                    int segment, int segmentCount);
+};
+
+template <typename DataType>
+void SweepLinePipeline<DataType>::onExecute()
+{
+	if (_stages.empty() || _stages.back().barrier)
+		throw std::logic_error("The pipeline must end with a computation stage.");
+	if (_stages.back().sink)
+		throw std::logic_error("The last stage of the pipeline cannot have a sink.");
+	if ((quantization.enabled || intermediateQuantization.enabled) && !std::is_floating_point<DataType>::value)
+		throw std::logic_error("Quantization requires a floating point data type.");
+
+	// Split the stages into segments by the barriers
+	std::vector<std::size_t> segmentBounds{ 0 };
+	for (std::size_t i = 0; i < _stages.size(); ++i)
+		if (_stages[i].barrier)
+		{
+			if (i == segmentBounds.back())
+				throw std::logic_error("A barrier must follow a computation stage.");
+			segmentBounds.push_back(i + 1);
+		}
+	segmentBounds.push_back(_stages.size() + 1);
+	int segmentCount = static_cast<int>(segmentBounds.size()) - 1;
+
+	// Create and open the target file
+	GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(targetFormat.c_str());
+	if (driver == nullptr)
+		throw std::invalid_argument("Target output format unrecognized.");
+
+	if (fs::exists(_targetPath) &&
+		driver->Delete(_targetPath.c_str()) == CE_Failure &&
+		!fs::remove(_targetPath))
+		throw std::runtime_error("Cannot overwrite previously created target file.");
+
+	nodataValue = _stages.back().nodataValue;
+	_targetDataset = createDataset(driver, _targetPath, createOptions, nodataValue, quantization);
+
+	// Open and check bands
+	GDALDataType sourceType = gdalType<DataType>();
+	std::vector<GDALRasterBand*> sourceBands(sourceCount());
+	for (unsigned int i = 0; i < sourceCount(); ++i)
+	{
+		long long bandIndex;
+		if (bands.size() > i)
+		{
+			// Use manually defined band index
+			bandIndex = bands[i];
+		}
+		else
+		{
+			// Default band index: multiplicity of same source
+			bandIndex = _sourceOwnership
+				? std::count(_sourcePaths.begin(), _sourcePaths.begin() + i, _sourcePaths[i]) + 1
+				: std::count(_sourceDatasets.begin(), _sourceDatasets.begin() + i, _sourceDatasets[i]) + 1;
+		}
+		sourceBands[i] = _sourceDatasets[i]->GetRasterBand(static_cast<int>(bandIndex));
+	}
+
+	if (strictTypes && std::any_of(sourceBands.begin(), sourceBands.end(),
+		[sourceType](GDALRasterBand* band)
+	{
+		return band->GetRasterDataType() != sourceType;
+	}))
+		throw std::domain_error("The data type of a source band does not match with the given data type.");
+
+	// Compute the segments, materializing the results before the barriers in their sinks or in memory
+	GDALDriver* memoryDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+	std::vector<RasterMetadata> sourceMetadata = _sourceMetadata;
+	GDALDataset* intermediateDataset = nullptr;
+	try
+	{
+		for (int segment = 0; segment < segmentCount; ++segment)
+		{
+			std::size_t firstStage = segmentBounds[segment];
+			std::size_t lastStage = segmentBounds[segment + 1] - 1;
+
+			if (segment == segmentCount - 1)
+			{
+				computeSegment(sourceBands, sourceMetadata, firstStage, lastStage,
+					_targetDataset->GetRasterBand(1), quantization, segment, segmentCount);
+				break;
+			}
+
+			const Stage& materializedStage = _stages[lastStage - 1];
+			GDALDataset* materializedDataset = materializedStage.sink
+				? createSink(materializedStage.sinkPath, materializedStage.nodataValue, intermediateQuantization)
+				: createDataset(memoryDriver, std::string(),
+					std::map<std::string, std::string>(), materializedStage.nodataValue, intermediateQuantization);
+			try
+			{
+				computeSegment(sourceBands, sourceMetadata, firstStage, lastStage,
+					materializedDataset->GetRasterBand(1), intermediateQuantization, segment, segmentCount);
+			}
+			catch (...)
+			{
+				GDALClose(materializedDataset);
+				throw;
+			}
+			if (intermediateDataset != nullptr)
+				GDALClose(intermediateDataset);
+
+			if (progress)
+				progress(static_cast<float>(segment + 1) / segmentCount, _stages[lastStage].message);
+			intermediateDataset = _stages[lastStage].barrier(materializedDataset);
+			if (intermediateDataset != materializedDataset)
+				GDALClose(materializedDataset);
+			if (intermediateDataset == nullptr)
+				throw std::runtime_error("Pipeline barrier failed.");
+
+			sourceBands = { intermediateDataset->GetRasterBand(1) };
+			sourceMetadata = { RasterMetadata(intermediateDataset) };
+		}
+	}
+	catch (...)
+	{
+		if (intermediateDataset != nullptr)
+			GDALClose(intermediateDataset);
+		throw;
+	}
+	if (intermediateDataset != nullptr)
+		GDALClose(intermediateDataset);
+}
+
+template <typename DataType>
+GDALDataset* SweepLinePipeline<DataType>::createDataset(
+	GDALDriver* driver, const std::string& path,
+	const std::map<std::string, std::string>& options,
+	double nodataValue, const Quantization& dataQuantization) const
+{
+	char **params = nullptr;
+	for (auto& co : options)
+		params = CSLSetNameValue(params, co.first.c_str(), co.second.c_str());
+
+	GDALDataset* dataset = driver->Create(path.c_str(),
+		_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY(), 1,
+		dataQuantization.enabled ? GDT_Int16 : gdalType<DataType>(), params);
+	CSLDestroy(params);
+	if (dataset == nullptr)
+		throw std::runtime_error("Target file creation failed.");
+
+	dataset->SetGeoTransform(&_targetMetadata.geoTransform()[0]);
+	if (_targetMetadata.reference().Validate() == OGRERR_NONE)
+	{
+		char *wkt;
+		_targetMetadata.reference().exportToWkt(&wkt);
+		dataset->SetProjection(wkt);
+		CPLFree(wkt);
+	}
+	dataset->GetRasterBand(1)->SetNoDataValue(nodataValue);
+	dataQuantization.apply(dataset->GetRasterBand(1));
+	return dataset;
+}
+
+template <typename DataType>
+GDALDataset* SweepLinePipeline<DataType>::createSink(
+	const std::string& path, double nodataValue, const Quantization& dataQuantization) const
+{
+	GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(targetFormat.c_str());
+	if (driver == nullptr)
+		throw std::invalid_argument("Target output format unrecognized.");
+
+	if (!path.empty() && fs::exists(path) &&
+		driver->Delete(path.c_str()) == CE_Failure &&
+		!fs::remove(path))
+		throw std::runtime_error("Cannot overwrite previously created sink file.");
+
+	return createDataset(driver, path, createOptions, nodataValue, dataQuantization);
+}
+
+template <typename DataType>
+void SweepLinePipeline<DataType>::computeSegment(
+	const std::vector<GDALRasterBand*>& sourceBands,
+	const std::vector<RasterMetadata>& sourceMetadata,
+	std::size_t firstStage, std::size_t lastStage,
+	GDALRasterBand* targetBand, const Quantization& targetQuantization,
+	int segment, int segmentCount)
+{
+	int sizeX = _targetMetadata.rasterSizeX();
+	int sizeY = _targetMetadata.rasterSizeY();
+
+	// Chain the stages: the first one reads the sources, the others the previous stage
+	std::vector<std::unique_ptr<StageRunner>> runners;
+	runners.reserve(lastStage - firstStage);
+	for (std::size_t s = firstStage; s < lastStage; ++s)
+	{
+		runners.emplace_back(new StageRunner(_stages[s], sizeX));
+		if (s == firstStage)
+			for (std::size_t i = 0; i < sourceBands.size(); ++i)
+			{
+				int sourceOffsetX = static_cast<int>((sourceMetadata[i].originX() - _targetMetadata.originX()) / std::abs(_targetMetadata.pixelSizeX()));
+				int sourceOffsetY = static_cast<int>((_targetMetadata.originY() - sourceMetadata[i].originY()) / std::abs(_targetMetadata.pixelSizeY()));
+				runners.back()->addSource(sourceBands[i], sourceOffsetX, sourceOffsetY);
+			}
+		else
+			runners.back()->addSource(*runners[runners.size() - 2], sizeY);
+	}
+
+	// The stages of the segment are computed simultaneously, so their messages are reported together
+	std::string message;
+	for (std::size_t s = firstStage; s < lastStage; ++s)
+		if (!_stages[s].message.empty())
+			message += (message.empty() ? "" : ", ") + _stages[s].message;
+
+	// The inner stages write their sinks, the last one is written to the target band
+	std::vector<GDALDataset*> sinkDatasets;
+	try
+	{
+		for (std::size_t s = firstStage; s + 1 < lastStage; ++s)
+			if (_stages[s].sink)
+			{
+				sinkDatasets.push_back(createSink(_stages[s].sinkPath, _stages[s].nodataValue, Quantization()));
+				runners[s - firstStage]->setSink(sinkDatasets.back()->GetRasterBand(1));
+			}
+
+		// Pull the rows through the stages
+		int progressStep = std::max(sizeY / 199, 1);
+		std::vector<DataType> targetScanline(sizeX);
+		for (int y = 0; y < sizeY; ++y)
+		{
+			runners.back()->compute(y, targetScanline.data());
+			targetQuantization.quantize(targetScanline.data(), targetScanline.size(), _stages[lastStage - 1].nodataValue);
+
+			if (targetBand->RasterIO(GF_Write,
+				0, y,
+				sizeX, 1,
+				&targetScanline[0], sizeX, 1,
+				gdalType<DataType>(), 0, 0) != CE_None)
+				throw std::runtime_error("Target write error occured.");
+
+			if (progress && ((y + 1) % progressStep == 0 || y + 1 == sizeY))
+				progress((segment + 1.f * (y + 1) / sizeY) / segmentCount, message);
+		}
+	}
+	catch (...)
+	{
+		for (GDALDataset* dataset : sinkDatasets)
+			GDALClose(dataset);
+		throw;
+	}
+	for (GDALDataset* dataset : sinkDatasets)
+		GDALClose(dataset);
+}
+} // DEM
+} // CloudTools
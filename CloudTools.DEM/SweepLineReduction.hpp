@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+
+#include "SweepLineCalculation.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+	/// <summary>
+	/// Represents a sweepline calculation on DEM datasets accumulating a result.
+	/// </summary>
+	/// <remarks>
+	/// Each worker thread accumulates into its own copy of the initial value, so the computation requires
+	/// no locking. The accumulators are merged by the combiner in the order of the computed bands after
+	/// the execution, therefore the result is reproducible for a given number of threads.
+	/// </remarks>
+	template <typename SourceType, typename AccumulatorType>
+	class SweepLineReduction : public SweepLineCalculation<SourceType,
+		std::function<void(int, int, const std::vector<Window<SourceType>>&)>>
+	{
+		typedef SweepLineCalculation<SourceType,
+			std::function<void(int, int, const std::vector<Window<SourceType>>&)>> BaseType;
+
+	public:
+		typedef std::function<void(int, int, const std::vector<Window<SourceType>>&, AccumulatorType&)> ReductionType;
+		/// <summary>
+		/// The callback function for computation, accumulating into the accumulator of the worker.
+		/// </summary>
+		ReductionType reduction;
+
+		typedef std::function<void(AccumulatorType&, const AccumulatorType&)> CombinerType;
+		/// <summary>
+		/// The callback function merging the second accumulator into the first one.
+		/// </summary>
+		CombinerType combiner;
+
+		/// <summary>
+		/// The initial value of the accumulators.
+		/// </summary>
+		AccumulatorType initialValue;
+
+	private:
+		std::vector<AccumulatorType> _accumulators;
+		std::vector<typename BaseType::ComputationType> _computations;
+		AccumulatorType _result;
+
+	public:
+		/// <summary>
+		/// Initializes a new instance of the class and loads source metadata.
+		/// </summary>
+		/// <param name="sourcePaths">The source files of the calculation.</param>
+		/// <param name="range">The range of surrounding data to involve in the computations.</param>
+		/// <param name="reduction">The callback function for computation.</param>
+		/// <param name="combiner">The callback function merging the accumulators.</param>
+		/// <param name="initialValue">The initial value of the accumulators.</param>
+		/// <param name="progress">The callback method to report progress.</param>
+		SweepLineReduction(const std::vector<std::string>& sourcePaths,
+		                   int range,
+		                   ReductionType reduction,
+		                   CombinerType combiner,
+		                   AccumulatorType initialValue = AccumulatorType(),
+		                   Operation::ProgressType progress = nullptr)
+			: BaseType(sourcePaths, range, nullptr, progress),
+			  reduction(reduction), combiner(combiner), initialValue(initialValue)
+		{ }
+
+		/// <summary>
+		/// Initializes a new instance of the class and loads source metadata.
+		/// </summary>
+		/// <param name="sourceDatasets">The source datasets of the calculation.</param>
+		/// <param name="range">The range of surrounding data to involve in the computations.</param>
+		/// <param name="reduction">The callback function for computation.</param>
+		/// <param name="combiner">The callback function merging the accumulators.</param>
+		/// <param name="initialValue">The initial value of the accumulators.</param>
+		/// <param name="progress">The callback method to report progress.</param>
+		SweepLineReduction(const std::vector<GDALDataset*>& sourceDatasets,
+		                   int range,
+		                   ReductionType reduction,
+		                   CombinerType combiner,
+		                   AccumulatorType initialValue = AccumulatorType(),
+		                   Operation::ProgressType progress = nullptr)
+			: BaseType(sourceDatasets, range, nullptr, progress),
+			  reduction(reduction), combiner(combiner), initialValue(initialValue)
+		{ }
+
+		SweepLineReduction(const SweepLineReduction&) = delete;
+		SweepLineReduction& operator=(const SweepLineReduction&) = delete;
+
+		/// <summary>
+		/// Retrieves the accumulated result.
+		/// </summary>
+		const AccumulatorType& result() const
+		{
+			if (!this->isExecuted())
+				throw std::logic_error("The computation is not executed.");
+			return _result;
+		}
+
+	protected:
+		/// <summary>
+		/// Executes the computation on the target area and merges the accumulators.
+		/// </summary>
+		void onExecute() override
+		{
+			if (!reduction)
+				throw std::logic_error("No computation method defined.");
+			if (!combiner)
+				throw std::logic_error("No combiner method defined.");
+
+			// The base computation is only verified to be defined, the workers use their own
+			this->computation = [](int, int, const std::vector<Window<SourceType>>&) {};
+			_accumulators.clear();
+			_computations.clear();
+			BaseType::onExecute();
+
+			_result = _accumulators.empty() ? initialValue : _accumulators.front();
+			for (std::size_t k = 1; k < _accumulators.size(); ++k)
+				combiner(_result, _accumulators[k]);
+			_accumulators.clear();
+			_computations.clear();
+		}
+
+		typename BaseType::ComputationType& workerComputation(int worker, int workerCount) override
+		{
+			if (_computations.empty())
+			{
+				_accumulators.assign(workerCount, initialValue);
+				_computations.resize(workerCount);
+				for (int k = 0; k < workerCount; ++k)
+				{
+					AccumulatorType* accumulator = &_accumulators[k];
+					_computations[k] = [this, accumulator](int x, int y, const std::vector<Window<SourceType>>& data)
+					{
+						reduction(x, y, data, *accumulator);
+					};
+				}
+			}
+			return _computations[worker];
+		}
+	};
+} // DEM
+} // CloudTools
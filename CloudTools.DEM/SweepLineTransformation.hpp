@@ -5,12 +5,20 @@
 #include <cmath>
 #include <functional>
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
 
 #include <boost/filesystem.hpp>
 
 #include "Transformation.h"
 #include "Window.hpp"
+#include "SweepLineDriver.hpp"
+#include "RowWindow.hpp"
+#include "BoxStatistics.hpp"
+#include "AsyncScanlineIO.hpp"
+#include "ComputedDataset.hpp"
 #include "Metadata.h"
 #include "Helper.h"
 
@@ -23,20 +31,129 @@ namespace DEM
 /// <summary>
 /// Represents a sweepline transformation on DEM datasets.
 /// </summary>
-template <typename TargetType, typename SourceType = TargetType>
+/// <remarks>
+/// The computation type may be any callable with the signature of the default <c>std::function</c> wrapper.
+/// Using a concrete functor type enables the computation to be inlined into the sweeping loop.
+/// </remarks>
+template <typename TargetType, typename SourceType = TargetType,
+          typename Computation = std::function<TargetType(int, int, const std::vector<Window<SourceType>>&)>>
 class SweepLineTransformation : public Transformation
 {
 public:
-	typedef std::function<TargetType(int, int, const std::vector<Window<SourceType>>&)> ComputationType;
+	typedef Computation ComputationType;
 	ComputationType computation;
+
+	typedef std::function<void(int, const std::vector<RowWindow<SourceType>>&, TargetType*)> RowComputationType;
+	/// <summary>
+	/// The callback function for computing a whole target row at once.
+	/// </summary>
+	/// <remarks>
+	/// When defined, it is used instead of the per-pixel computation. It receives the target row index,
+	/// the row windows of the sources and the target scanline to fill.
+	/// </remarks>
+	RowComputationType rowComputation;
 	/// <summary>
 	/// The indices of bands to use respectively for each data source.
 	/// </summary>
 	std::vector<int> bands;
 
+	/// <summary>
+	/// The number of threads to compute the target with.
+	/// </summary>
+	/// <remarks>
+	/// With multiple threads the target is split into horizontal bands, which are computed parallelly
+	/// with separate source dataset handles. The computation method must be thread-safe in this mode.
+	/// </remarks>
+	unsigned int threadCount = 1;
+
+	/// <summary>
+	/// Specifies whether to iterate over the target by the native blocks of the sources instead of scanlines.
+	/// </summary>
+	/// <remarks>
+	/// The tiles are aligned to the blocks of the first source band. When the sources are
+	/// tiled, each tile (expanded by the range) is read with a single I/O request and the target
+	/// is written tile by tile. Falls back to the scanline iteration for stripped sources.
+	/// The computation is called for the target positions in tile order in this mode.
+	/// The row computation is always performed by scanlines.
+	/// </remarks>
+	bool blockIteration = false;
+
+	/// <summary>
+	/// Specifies whether to overlap the raster I/O with the computation.
+	/// </summary>
+	/// <remarks>
+	/// The source scanlines are read ahead and the target scanlines are written behind
+	/// by background threads through bounded queues. Applies to the scanline iterations.
+	/// The readers of sources sharing a dataset are serialized, as GDAL datasets are not thread-safe.
+	/// </remarks>
+	bool asyncIO = false;
+
+	/// <summary>
+	/// Specifies whether to maintain the sums and the counts of the valid data in the columns of the row windows.
+	/// </summary>
+	/// <remarks>
+	/// The column statistics are updated incrementally as the target row advances, enabling the row computation
+	/// to evaluate box window statistics in constant time per position by <see cref="boxStatistics"/>.
+	/// </remarks>
+	bool columnStatistics = false;
+
+	/// <summary>
+	/// Specifies whether to compute only the target positions around the valid data of the first source.
+	/// </summary>
+	/// <remarks>
+	/// The positions whose window contains no valid data of the first source are set to nodata without calling
+	/// the computation, which is only correct if the computation results nodata for them as well.
+	/// The per-pixel computation is called only for the runs of occupied positions of each row, the row
+	/// computation is skipped for rows without any. Applies to the scanline iterations.
+	/// </remarks>
+	bool sparse = false;
+
+	/// <summary>
+	/// Specifies whether to compute the target on demand instead of producing it at execution.
+	/// </summary>
+	/// <remarks>
+	/// The target is a read-only virtual dataset whose blocks are computed when they are read,
+	/// so a consumer reading only a part of the raster pays only for the blocks it touches.
+	/// The computation is performed at read time, therefore the transformation and its sources
+	/// must not be destroyed before the target. The target format and creation options are ignored,
+	/// quantization is not supported. The blocks read concurrently are computed parallelly,
+	/// the computation method must be thread-safe in this mode.
+	/// </remarks>
+	bool lazyTarget = false;
+
+	/// <summary>
+	/// The maximal number of computed blocks kept in memory by the on demand target besides the GDAL block cache.
+	/// </summary>
+	/// <remarks>
+	/// Disabled by default, as the blocks are only computed on GDAL block cache misses.
+	/// </remarks>
+	unsigned int lazyCacheSize = 0;
+
 protected:
 	int _range;
 
+private:
+	SweepLineLayout _layout;
+
+	/// <summary>
+	/// The source handles read by the on demand target.
+	/// </summary>
+	std::unique_ptr<SweepLineSources> _lazySources;
+
+	/// <summary>
+	/// The number of scanlines to buffer in the background I/O queues.
+	/// </summary>
+	static const int ioQueueDepth = 16;
+
+	/// <summary>
+	/// The size of the tiles computed on demand by the lazy target.
+	/// </summary>
+	/// <remarks>
+	/// With row computation whole scanlines are computed in strips of this height instead.
+	/// </remarks>
+	static const int lazyBlockSize = 256;
+	static const int lazyStripSize = 16;
+
 public:
 	/// <summary>
 	/// Initializes a new instance of the class and loads source metadata.
@@ -123,10 +240,99 @@ protected:
 	/// Produces the target file.
 	/// </summary>
 	void onExecute() override;
+
+private:
+	/// <summary>
+	/// Computes a horizontal band of the target.
+	/// </summary>
+	/// <param name="sourceBands">The source bands to read.</param>
+	/// <param name="sourceMutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	/// <param name="targetBand">The target band to write.</param>
+	/// <param name="targetMutex">The mutex guarding the target band, <c>nullptr</c> when not shared.</param>
+	/// <param name="firstRow">The first row of the band.</param>
+	/// <param name="lastRow">The row after the last row of the band.</param>
+	/// <param name="rowDone">The callback to report a finished row.</param>
+	void computeRows(const std::vector<GDALRasterBand*>& sourceBands,
+	                 const std::vector<std::mutex*>& sourceMutexes,
+	                 GDALRasterBand* targetBand, std::mutex* targetMutex,
+	                 int firstRow, int lastRow,
+	                 const std::function<void()>& rowDone);
+
+	/// <summary>
+	/// Computes a horizontal band of the target with the row computation.
+	/// </summary>
+	/// <param name="sourceBands">The source bands to read.</param>
+	/// <param name="sourceMutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	/// <param name="targetBand">The target band to write.</param>
+	/// <param name="targetMutex">The mutex guarding the target band, <c>nullptr</c> when not shared.</param>
+	/// <param name="firstRow">The first row of the band.</param>
+	/// <param name="lastRow">The row after the last row of the band.</param>
+	/// <param name="rowDone">The callback to report a finished row.</param>
+	void computeSpans(const std::vector<GDALRasterBand*>& sourceBands,
+	                  const std::vector<std::mutex*>& sourceMutexes,
+	                  GDALRasterBand* targetBand, std::mutex* targetMutex,
+	                  int firstRow, int lastRow,
+	                  const std::function<void()>& rowDone);
+
+	/// <summary>
+	/// Writes a computed row of the target, directly or through the background writer.
+	/// </summary>
+	/// <param name="targetBand">The target band to write.</param>
+	/// <param name="targetMutex">The mutex guarding the target band, <c>nullptr</c> when not shared.</param>
+	/// <param name="targetWriter">The background writer, <c>nullptr</c> to write directly.</param>
+	/// <param name="row">The index of the row.</param>
+	/// <param name="scanline">The computed row.</param>
+	void writeRow(GDALRasterBand* targetBand, std::mutex* targetMutex,
+	              ScanlineWriter<TargetType>* targetWriter,
+	              int row, TargetType* scanline);
+
+	/// <summary>
+	/// Computes a range of tiles of the target.
+	/// </summary>
+	/// <param name="sourceBands">The source bands to read.</param>
+	/// <param name="sourceMutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	/// <param name="targetBand">The target band to write.</param>
+	/// <param name="targetMutex">The mutex guarding the target band, <c>nullptr</c> when not shared.</param>
+	/// <param name="firstBlock">The row-major index of the first tile.</param>
+	/// <param name="lastBlock">The index after the last tile.</param>
+	/// <param name="blockDone">The callback to report a finished tile.</param>
+	void computeBlocks(const std::vector<GDALRasterBand*>& sourceBands,
+	                   const std::vector<std::mutex*>& sourceMutexes,
+	                   GDALRasterBand* targetBand, std::mutex* targetMutex,
+	                   int firstBlock, int lastBlock,
+	                   const std::function<void()>& blockDone);
+
+	/// <summary>
+	/// Computes a rectangular tile of the target into a buffer.
+	/// </summary>
+	/// <param name="sourceWindows">The windows to read the sources with, large enough for the tile.</param>
+	/// <param name="tileOffsetX">The abcissa offset of the tile.</param>
+	/// <param name="tileOffsetY">The ordinate offset of the tile.</param>
+	/// <param name="tileSizeX">The width of the tile.</param>
+	/// <param name="tileSizeY">The height of the tile.</param>
+	/// <param name="target">The row-major target buffer of the tile.</param>
+	void computeTile(TileWindows<SourceType>& sourceWindows,
+	                 int tileOffsetX, int tileOffsetY, int tileSizeX, int tileSizeY,
+	                 TargetType* target);
+
+	/// <summary>
+	/// Creates the row window caches of the sources.
+	/// </summary>
+	/// <param name="sourceBands">The source bands to read.</param>
+	/// <param name="sourceMutexes">The mutexes guarding the source bands, <c>nullptr</c> when not shared.</param>
+	std::vector<std::unique_ptr<RowWindowCache<SourceType>>> createRowCaches(
+		const std::vector<GDALRasterBand*>& sourceBands,
+		const std::vector<std::mutex*>& sourceMutexes);
+
+	/// <summary>
+	/// Creates the target dataset computing its blocks on demand.
+	/// </summary>
+	/// <param name="bandIndexes">The indices of the source bands to read.</param>
+	GDALDataset* createLazyTarget(const std::vector<int>& bandIndexes);
 };
 
-template <typename TargetType, typename SourceType>
-SweepLineTransformation<TargetType, SourceType>::SweepLineTransformation(
+template <typename TargetType, typename SourceType, typename Computation>
+SweepLineTransformation<TargetType, SourceType, Computation>::SweepLineTransformation(
 	const std::vector<std::string>& sourcePaths,
 	const std::string& targetPath,
 	int range,
@@ -138,8 +344,8 @@ SweepLineTransformation<TargetType, SourceType>::SweepLineTransformation(
 	setRange(range);
 }
 
-template <typename TargetType, typename SourceType>
-SweepLineTransformation<TargetType, SourceType>::SweepLineTransformation(
+template <typename TargetType, typename SourceType, typename Computation>
+SweepLineTransformation<TargetType, SourceType, Computation>::SweepLineTransformation(
 	const std::vector<GDALDataset*>& sourceDatasets,
 	const std::string& targetPath,
 	int range,
@@ -151,59 +357,28 @@ SweepLineTransformation<TargetType, SourceType>::SweepLineTransformation(
 	setRange(range);
 }
 
-template <typename TargetType, typename SourceType>
-void SweepLineTransformation<TargetType, SourceType>::setRange(int value)
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::setRange(int value)
 {
 	if (value < 0)
 		throw std::out_of_range("Range must be non-negative.");
 	_range = value;
 }
 
-template <typename TargetType, typename SourceType>
-void SweepLineTransformation<TargetType, SourceType>::onExecute()
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::onExecute()
 {
-	if (!computation)
+	if (!rowComputation && !isDefined(computation))
 		throw std::logic_error("No computation method defined.");
-
-	// Create and open the target file
-	GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(targetFormat.c_str());
-	if (driver == nullptr)
-		throw std::invalid_argument("Target output format unrecognized.");
-
-	if (fs::exists(_targetPath) &&
-		driver->Delete(_targetPath.c_str()) == CE_Failure &&
-		!fs::remove(_targetPath))
-		throw std::runtime_error("Cannot overwrite previously created target file.");
+	if (quantization.enabled && !std::is_floating_point<TargetType>::value)
+		throw std::logic_error("Quantization requires a floating point target type.");
+	if (quantization.enabled && lazyTarget)
+		throw std::logic_error("Quantization is not supported by targets computed on demand.");
 
 	GDALDataType sourceType = gdalType<SourceType>();
-	GDALDataType targetType = gdalType<TargetType>();
-
-	char **targetParams = nullptr;
-	for (auto& co : createOptions)
-		targetParams = CSLSetNameValue(targetParams, co.first.c_str(), co.second.c_str());
-
-	_targetDataset = driver->Create(_targetPath.c_str(),
-		_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY(), 1,
-		targetType, targetParams);
-	CSLDestroy(targetParams);
-	if (_targetDataset == nullptr)
-		throw std::runtime_error("Target file creation failed.");
-
-	_targetDataset->SetGeoTransform(&_targetMetadata.geoTransform()[0]);
-	if (_targetMetadata.reference().Validate() == OGRERR_NONE)
-	{
-		char *wkt;
-		_targetMetadata.reference().exportToWkt(&wkt);
-		_targetDataset->SetProjection(wkt);
-		CPLFree(wkt);
-	}
-
-	// Determine computation progress steps
-	int computationSize = _targetMetadata.rasterSizeY();
-	int computationStep = computationSize / 199;
-	int computationProgress = 0;
 
 	// Open and check bands
+	std::vector<int> bandIndexes(sourceCount());
 	std::vector<GDALRasterBand*> sourceBands(sourceCount());
 	for (unsigned int i = 0; i < sourceCount(); ++i)
 	{
@@ -220,10 +395,9 @@ void SweepLineTransformation<TargetType, SourceType>::onExecute()
 				? std::count(_sourcePaths.begin(), _sourcePaths.begin() + i, _sourcePaths[i]) + 1
 				: std::count(_sourceDatasets.begin(), _sourceDatasets.begin() + i, _sourceDatasets[i]) + 1;
 		}
-		sourceBands[i] = _sourceDatasets[i]->GetRasterBand(static_cast<int>(bandIndex));
+		bandIndexes[i] = static_cast<int>(bandIndex);
+		sourceBands[i] = _sourceDatasets[i]->GetRasterBand(bandIndexes[i]);
 	}
-	GDALRasterBand* targetBand = _targetDataset->GetRasterBand(1);
-	targetBand->SetNoDataValue(nodataValue);
 
 	if (strictTypes && std::any_of(sourceBands.begin(), sourceBands.end(),
 		[sourceType](GDALRasterBand* band)
@@ -232,81 +406,359 @@ void SweepLineTransformation<TargetType, SourceType>::onExecute()
 	}))
 		throw std::domain_error("The data type of a source band does not match with the given data type.");
 
+	// Create and open the target file
+	if (lazyTarget)
+		_targetDataset = createLazyTarget(bandIndexes);
+	else
+	{
+		GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(targetFormat.c_str());
+		if (driver == nullptr)
+			throw std::invalid_argument("Target output format unrecognized.");
+
+		if (fs::exists(_targetPath) &&
+			driver->Delete(_targetPath.c_str()) == CE_Failure &&
+			!fs::remove(_targetPath))
+			throw std::runtime_error("Cannot overwrite previously created target file.");
+
+		char **targetParams = nullptr;
+		for (auto& co : createOptions)
+			targetParams = CSLSetNameValue(targetParams, co.first.c_str(), co.second.c_str());
+
+		_targetDataset = driver->Create(_targetPath.c_str(),
+			_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY(), 1,
+			quantization.enabled ? GDT_Int16 : gdalType<TargetType>(), targetParams);
+		CSLDestroy(targetParams);
+		if (_targetDataset == nullptr)
+			throw std::runtime_error("Target file creation failed.");
+	}
+
+	_targetDataset->SetGeoTransform(&_targetMetadata.geoTransform()[0]);
+	if (_targetMetadata.reference().Validate() == OGRERR_NONE)
+	{
+		char *wkt;
+		_targetMetadata.reference().exportToWkt(&wkt);
+		_targetDataset->SetProjection(wkt);
+		CPLFree(wkt);
+	}
+
+	GDALRasterBand* targetBand = _targetDataset->GetRasterBand(1);
+	targetBand->SetNoDataValue(nodataValue);
+
+	if (lazyTarget)
+		return;
+	quantization.apply(targetBand);
+
+	// Determine the iteration layout
+	int sourceOffsetX = 0, sourceOffsetY = 0;
+	if (!sourceBands.empty())
+		rasterOffset(_sourceMetadata[0], _targetMetadata, sourceOffsetX, sourceOffsetY);
+	_layout = blockIteration && !rowComputation && !sourceBands.empty()
+		? SweepLineLayout(_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY(), sourceBands[0],
+		                  sourceOffsetX, sourceOffsetY)
+		: SweepLineLayout(_targetMetadata.rasterSizeX(), _targetMetadata.rasterSizeY());
+	auto compute = rowComputation ? &SweepLineTransformation::computeSpans
+		: _layout.tiled() ? &SweepLineTransformation::computeBlocks : &SweepLineTransformation::computeRows;
+
+	// Determine computation progress steps
+	int computationSize = _layout.count();
+	SweepLineProgress computationProgress(progress, computationSize);
+	std::function<void()> stepDone = [&computationProgress]() { computationProgress.step(); };
+
+	// Compute the horizontal bands (or ranges of tiles) parallelly
+	int workerCount = static_cast<int>(std::min<unsigned int>(
+		std::max(threadCount, 1u), std::max(computationSize, 1)));
+	SweepLineSources sources(_sourceDatasets, bandIndexes, workerCount,
+		asyncIO ? SweepLineSources::ReadMode::Concurrent : SweepLineSources::ReadMode::Sequential,
+		[this](unsigned int index) { return openSourceHandle(index); });
+	std::mutex targetMutex;
+	runWorkers(computationSize, workerCount, [&](int worker, int first, int last)
+	{
+		(this->*compute)(sources.bands(worker), sources.mutexes(worker),
+		                 targetBand, workerCount > 1 ? &targetMutex : nullptr,
+		                 first, last, stepDone);
+	});
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::computeRows(
+	const std::vector<GDALRasterBand*>& sourceBands,
+	const std::vector<std::mutex*>& sourceMutexes,
+	GDALRasterBand* targetBand, std::mutex* targetMutex,
+	int firstRow, int lastRow,
+	const std::function<void()>& rowDone)
+{
 	// Define windows
-	int windowSize = 2 * _range + 1;
-	std::vector<Window<SourceType>> dataWindows;
-	dataWindows.reserve(sourceCount());
+	ScanlineWindows<SourceType> sourceWindows(sourceBands, sourceMutexes, _sourceMetadata, _targetMetadata, _range);
+	if (asyncIO)
+		sourceWindows.prefetch(firstRow, lastRow, ioQueueDepth);
+	std::vector<Window<SourceType>>& dataWindows = sourceWindows.windows();
 
 	// Read sources and compute target
-	SourceType** sourceScanlines = new SourceType*[sourceCount()];
-	for (unsigned int i = 0; i < sourceCount(); ++i)
-		sourceScanlines[i] = new SourceType[_sourceMetadata[i].rasterSizeX() * windowSize];
-	TargetType* targetScanline = new TargetType[_targetMetadata.rasterSizeX()];
+	std::vector<TargetType> targetScanline(_targetMetadata.rasterSizeX());
+	std::unique_ptr<ScanlineWriter<TargetType>> targetWriter;
+	if (asyncIO)
+		targetWriter.reset(new ScanlineWriter<TargetType>(targetBand, ioQueueDepth, targetMutex));
+	std::vector<ValidityRun> runs;
 
-	for (int y = 0; y < _targetMetadata.rasterSizeY(); ++y)
+	for (int y = firstRow; y < lastRow; ++y)
 	{
-		CPLErr ioResult = CE_None;
+		if (sourceWindows.fetch(y) != CE_None)
+			throw std::runtime_error("Source read error occured.");
 
-		dataWindows.clear();
-		for (unsigned int i = 0; i < sourceCount(); ++i)
+		TargetType* scanline = targetWriter ? targetWriter->acquire() : targetScanline.data();
+		if (sparse)
 		{
-			int sourceOffsetX = static_cast<int>((_sourceMetadata[i].originX() - _targetMetadata.originX()) / std::abs(_targetMetadata.pixelSizeX()));
-			int sourceOffsetY = static_cast<int>((_targetMetadata.originY() - _sourceMetadata[i].originY()) / std::abs(_targetMetadata.pixelSizeY()));
+			// Only the runs around the valid data of the first source are computed
+			sourceWindows.occupancy(runs);
+			std::fill(scanline, scanline + _targetMetadata.rasterSizeX(), static_cast<TargetType>(nodataValue));
+		}
+		else
+			runs.assign(1, ValidityRun{ 0, _targetMetadata.rasterSizeX() });
 
-			if (y + _range >= sourceOffsetY &&
-				y - _range < sourceOffsetY + _sourceMetadata[i].rasterSizeY())
+		for (const ValidityRun& run : runs)
+			for (int x = run.begin; x < run.end; ++x)
 			{
-				int readOffsetX = 0;
-				int readOffsetY = std::max(0, -sourceOffsetY + y - _range);
-				int readSizeX = _sourceMetadata[i].rasterSizeX();
-				int readSizeY = -readOffsetY + std::min(readOffsetY + windowSize, _sourceMetadata[i].rasterSizeY());
-
-				ioResult = static_cast<CPLErr>(ioResult |
-					sourceBands[i]->RasterIO(GF_Read,
-						readOffsetX, readOffsetY,
-						readSizeX, readSizeY,
-						sourceScanlines[i], _sourceMetadata[i].rasterSizeX(), windowSize,
-						sourceType, 0, 0));
-
-				dataWindows.emplace_back(sourceScanlines[i], 
-					static_cast<SourceType>(sourceBands[i]->GetNoDataValue()),
-					readSizeX, readSizeY,
-					sourceOffsetX + readOffsetX, sourceOffsetY + readOffsetY,
-					0, y);
+				for (Window<SourceType>& window : dataWindows)
+					window.centerX = x;
+				scanline[x] = computation(x, y, dataWindows);
 			}
-			else
-				dataWindows.emplace_back(sourceScanlines[i], 
-					static_cast<SourceType>(sourceBands[i]->GetNoDataValue()),
-					0, 0,
-					sourceOffsetX, sourceOffsetY,
-					0, y);
+
+		writeRow(targetBand, targetMutex, targetWriter.get(), y, scanline);
+		rowDone();
+	}
+
+	if (targetWriter)
+		targetWriter->finish();
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::computeSpans(
+	const std::vector<GDALRasterBand*>& sourceBands,
+	const std::vector<std::mutex*>& sourceMutexes,
+	GDALRasterBand* targetBand, std::mutex* targetMutex,
+	int firstRow, int lastRow,
+	const std::function<void()>& rowDone)
+{
+	// Define row windows
+	std::vector<RowWindow<SourceType>> rowWindows;
+	rowWindows.reserve(sourceCount());
+
+	std::vector<std::unique_ptr<RowWindowCache<SourceType>>> sourceCaches =
+		createRowCaches(sourceBands, sourceMutexes);
+	if (asyncIO)
+		for (auto& cache : sourceCaches)
+			cache->prefetch(firstRow, lastRow, ioQueueDepth);
+
+	// Read sources and compute target
+	std::vector<TargetType> targetScanline(_targetMetadata.rasterSizeX());
+	std::unique_ptr<ScanlineWriter<TargetType>> targetWriter;
+	if (asyncIO)
+		targetWriter.reset(new ScanlineWriter<TargetType>(targetBand, ioQueueDepth, targetMutex));
+	std::vector<ValidityRun> runs;
+
+	for (int y = firstRow; y < lastRow; ++y)
+	{
+		CPLErr ioResult = CE_None;
+
+		rowWindows.clear();
+		for (unsigned int i = 0; i < sourceCount(); ++i)
+		{
+			ioResult = static_cast<CPLErr>(ioResult | sourceCaches[i]->fetch(y));
+			rowWindows.push_back(sourceCaches[i]->window());
 		}
 		if (ioResult != CE_None)
 			throw std::runtime_error("Source read error occured.");
 
-		for (int x = 0; x < _targetMetadata.rasterSizeX(); ++x)
-		{
-			for (Window<SourceType>& window : dataWindows)
-				window.centerX = x;
-			targetScanline[x] = computation(x, y, dataWindows);
-		}
+		TargetType* scanline = targetWriter ? targetWriter->acquire() : targetScanline.data();
+		if (sparse && sourceCount() > 0)
+			sourceCaches[0]->occupancy(runs);
+		if (sparse && sourceCount() > 0 && runs.empty())
+			std::fill(scanline, scanline + _targetMetadata.rasterSizeX(), static_cast<TargetType>(nodataValue));
+		else
+			rowComputation(y, rowWindows, scanline);
+
+		writeRow(targetBand, targetMutex, targetWriter.get(), y, scanline);
+		rowDone();
+	}
+
+	if (targetWriter)
+		targetWriter->finish();
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::writeRow(
+	GDALRasterBand* targetBand, std::mutex* targetMutex,
+	ScanlineWriter<TargetType>* targetWriter,
+	int row, TargetType* scanline)
+{
+	quantization.quantize(scanline, static_cast<std::size_t>(_targetMetadata.rasterSizeX()), nodataValue);
+	if (targetWriter != nullptr)
+	{
+		targetWriter->write(row, scanline);
+		return;
+	}
+
+	CPLErr ioResult;
+	{
+		std::unique_lock<std::mutex> lock;
+		if (targetMutex != nullptr)
+			lock = std::unique_lock<std::mutex>(*targetMutex);
 
 		ioResult = targetBand->RasterIO(GF_Write,
-			0, y,
+			0, row,
 			_targetMetadata.rasterSizeX(), 1,
-			targetScanline, _targetMetadata.rasterSizeX(), 1,
-			targetType, 0, 0);
+			scanline, _targetMetadata.rasterSizeX(), 1,
+			gdalType<TargetType>(), 0, 0);
+	}
+	if (ioResult != CE_None)
+		throw std::runtime_error("Target write error occured.");
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::computeBlocks(
+	const std::vector<GDALRasterBand*>& sourceBands,
+	const std::vector<std::mutex*>& sourceMutexes,
+	GDALRasterBand* targetBand, std::mutex* targetMutex,
+	int firstBlock, int lastBlock,
+	const std::function<void()>& blockDone)
+{
+	GDALDataType targetType = gdalType<TargetType>();
+
+	// Read sources and compute target
+	TileWindows<SourceType> sourceWindows(sourceBands, sourceMutexes, _sourceMetadata, _targetMetadata,
+		_range, _layout.blockSizeX(), _layout.blockSizeY());
+	std::vector<TargetType> targetBlock(static_cast<std::size_t>(_layout.blockSizeX()) * _layout.blockSizeY());
+
+	for (int block = firstBlock; block < lastBlock; ++block)
+	{
+		int blockOffsetX, blockOffsetY, blockSizeX, blockSizeY;
+		_layout.tile(block, blockOffsetX, blockOffsetY, blockSizeX, blockSizeY);
+
+		computeTile(sourceWindows, blockOffsetX, blockOffsetY, blockSizeX, blockSizeY, &targetBlock[0]);
+		quantization.quantize(&targetBlock[0], static_cast<std::size_t>(blockSizeX) * blockSizeY, nodataValue);
+
+		CPLErr ioResult;
+		{
+			std::unique_lock<std::mutex> lock;
+			if (targetMutex != nullptr)
+				lock = std::unique_lock<std::mutex>(*targetMutex);
+
+			ioResult = targetBand->RasterIO(GF_Write,
+				blockOffsetX, blockOffsetY,
+				blockSizeX, blockSizeY,
+				&targetBlock[0], blockSizeX, blockSizeY,
+				targetType, 0, 0);
+		}
 		if (ioResult != CE_None)
 			throw std::runtime_error("Target write error occured.");
 
-		if (progress && (computationProgress++ % computationStep == 0 || computationProgress == computationSize))
-			progress(1.f * computationProgress / computationSize, std::string());
+		blockDone();
+	}
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+void SweepLineTransformation<TargetType, SourceType, Computation>::computeTile(
+	TileWindows<SourceType>& sourceWindows,
+	int tileOffsetX, int tileOffsetY, int tileSizeX, int tileSizeY,
+	TargetType* target)
+{
+	if (sourceWindows.fetch(tileOffsetX, tileOffsetY, tileSizeX, tileSizeY) != CE_None)
+		throw std::runtime_error("Source read error occured.");
+	std::vector<Window<SourceType>>& dataWindows = sourceWindows.windows();
+
+	// Compute target
+	for (int y = tileOffsetY; y < tileOffsetY + tileSizeY; ++y)
+	{
+		TargetType* targetRow = target + static_cast<std::size_t>(y - tileOffsetY) * tileSizeX;
+		for (int x = tileOffsetX; x < tileOffsetX + tileSizeX; ++x)
+		{
+			for (Window<SourceType>& window : dataWindows)
+			{
+				window.centerX = x;
+				window.centerY = y;
+			}
+			targetRow[x - tileOffsetX] = computation(x, y, dataWindows);
+		}
 	}
+}
 
+template <typename TargetType, typename SourceType, typename Computation>
+std::vector<std::unique_ptr<RowWindowCache<SourceType>>>
+SweepLineTransformation<TargetType, SourceType, Computation>::createRowCaches(
+	const std::vector<GDALRasterBand*>& sourceBands,
+	const std::vector<std::mutex*>& sourceMutexes)
+{
+	std::vector<std::unique_ptr<RowWindowCache<SourceType>>> sourceCaches;
+	sourceCaches.reserve(sourceCount());
 	for (unsigned int i = 0; i < sourceCount(); ++i)
-		delete[] sourceScanlines[i];
-	delete[] sourceScanlines;
-	delete[] targetScanline;
+	{
+		int sourceOffsetX, sourceOffsetY;
+		rasterOffset(_sourceMetadata[i], _targetMetadata, sourceOffsetX, sourceOffsetY);
+		sourceCaches.emplace_back(new RowWindowCache<SourceType>(sourceBands[i],
+			_targetMetadata.rasterSizeX(), _range,
+			sourceOffsetX, sourceOffsetY,
+			static_cast<SourceType>(Quantization::nodataValue(sourceBands[i])),
+			sourceMutexes[i]));
+		sourceCaches[i]->setColumnStatistics(columnStatistics);
+	}
+	return sourceCaches;
+}
+
+template <typename TargetType, typename SourceType, typename Computation>
+GDALDataset* SweepLineTransformation<TargetType, SourceType, Computation>::createLazyTarget(
+	const std::vector<int>& bandIndexes)
+{
+	int sizeX = _targetMetadata.rasterSizeX();
+	int sizeY = _targetMetadata.rasterSizeY();
+	int tileSize = lazyBlockSize;
+	int stripSize = lazyStripSize;
+	typename ComputedDataset<TargetType>::ProviderType provider;
+
+	// The blocks might be computed concurrently, so all source handles are guarded
+	_lazySources.reset(new SweepLineSources(_sourceDatasets, bandIndexes, 1,
+		SweepLineSources::ReadMode::Shared, nullptr));
+
+	if (rowComputation)
+	{
+		// Whole scanlines are computed in horizontal strips
+		provider = [this, sizeX](int offsetX, int offsetY, int tileSizeX, int tileSizeY, TargetType* target)
+		{
+			std::vector<std::unique_ptr<RowWindowCache<SourceType>>> sourceCaches =
+				createRowCaches(_lazySources->bands(0), _lazySources->mutexes(0));
+			std::vector<RowWindow<SourceType>> rowWindows;
+			rowWindows.reserve(sourceCount());
+
+			for (int y = offsetY; y < offsetY + tileSizeY; ++y)
+			{
+				CPLErr ioResult = CE_None;
+				rowWindows.clear();
+				for (auto& cache : sourceCaches)
+				{
+					ioResult = static_cast<CPLErr>(ioResult | cache->fetch(y));
+					rowWindows.push_back(cache->window());
+				}
+				if (ioResult != CE_None)
+					throw std::runtime_error("Source read error occured.");
+
+				rowComputation(y, rowWindows, target + static_cast<std::size_t>(y - offsetY) * sizeX);
+			}
+		};
+		return new ComputedDataset<TargetType>(sizeX, sizeY,
+			std::max(sizeX, 1), std::max(std::min(stripSize, sizeY), 1),
+			provider, lazyCacheSize);
+	}
+
+	int blockSizeX = std::max(std::min(tileSize, sizeX), 1);
+	int blockSizeY = std::max(std::min(tileSize, sizeY), 1);
+	provider = [this, blockSizeX, blockSizeY](int offsetX, int offsetY, int tileSizeX, int tileSizeY, TargetType* target)
+	{
+		TileWindows<SourceType> sourceWindows(_lazySources->bands(0), _lazySources->mutexes(0),
+			_sourceMetadata, _targetMetadata, _range, blockSizeX, blockSizeY);
+		computeTile(sourceWindows, offsetX, offsetY, tileSizeX, tileSizeY, target);
+	};
+	return new ComputedDataset<TargetType>(sizeX, sizeY,
+		blockSizeX, blockSizeY,
+		provider, lazyCacheSize);
 }
 } // DEM
 } // CloudTools
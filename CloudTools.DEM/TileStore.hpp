@@ -0,0 +1,301 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#include <gdal_priv.h>
+
+#include "Helper.h"
+#include "Quantization.hpp"
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a paged, random access store of a raster band with fixed-size tiles.
+/// </summary>
+/// <remarks>
+/// The tiles are read from the band on demand and at most the given number of tiles is kept in memory,
+/// the least recently used tile is evicted when a new one is required. Modified tiles of a writable
+/// store are written back to the band on eviction and by <see cref="flush"/>, the tiles not yet stored
+/// in the band are initialized with the fill value instead of being read.
+/// Once all tiles are resident after <see cref="preload"/>, the values can be accessed concurrently
+/// (writing distinct positions). Otherwise the store is only thread-safe in concurrent mode,
+/// which serializes the accesses. As the stores of different bands of a dataset read the same handle,
+/// their band accesses must be serialized by a common I/O mutex in concurrent mode.
+/// </remarks>
+template <typename DataType>
+class TileStore
+{
+private:
+	struct Slot
+	{
+		int tile;
+		bool dirty;
+		unsigned long long lastUse;
+		std::vector<DataType> data;
+	};
+
+	GDALRasterBand* _band;
+	Quantization _quantization;
+	bool _writable;
+	DataType _fillValue;
+	int _sizeX;
+	int _sizeY;
+	int _tileSizeX;
+	int _tileSizeY;
+	int _tileCountX;
+	std::size_t _maxTiles;
+
+	std::vector<Slot> _slots;
+	std::vector<int> _slotOfTile;
+	std::vector<bool> _stored;
+	unsigned long long _useCounter;
+	bool _resident;
+	bool _concurrent;
+	std::mutex _mutex;
+	std::mutex* _ioMutex;
+
+	int _lastTile;
+	Slot* _lastSlot;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class.
+	/// </summary>
+	/// <param name="band">The raster band to page.</param>
+	/// <param name="tileSizeX">The width of a tile.</param>
+	/// <param name="tileSizeY">The height of a tile.</param>
+	/// <param name="maxTiles">The maximal number of tiles in memory.</param>
+	/// <param name="writable">Specifies whether the band is modified through the store.</param>
+	/// <param name="fillValue">The initial value of a writable band.</param>
+	TileStore(GDALRasterBand* band, int tileSizeX, int tileSizeY, std::size_t maxTiles,
+	          bool writable = false, DataType fillValue = 0)
+		: _band(band), _quantization(Quantization::of(band)), _writable(writable), _fillValue(fillValue),
+		  _sizeX(band->GetXSize()), _sizeY(band->GetYSize()),
+		  _tileSizeX(tileSizeX), _tileSizeY(tileSizeY),
+		  _maxTiles(std::max<std::size_t>(maxTiles, 1)),
+		  _useCounter(0), _resident(false), _concurrent(false), _ioMutex(nullptr),
+		  _lastTile(-1), _lastSlot(nullptr)
+	{
+		if (_tileSizeX < 1 || _tileSizeY < 1)
+			throw std::invalid_argument("The tile size must be positive.");
+
+		_tileCountX = (_sizeX + _tileSizeX - 1) / _tileSizeX;
+		int tileCountY = (_sizeY + _tileSizeY - 1) / _tileSizeY;
+		_slotOfTile.assign(static_cast<std::size_t>(_tileCountX) * tileCountY, -1);
+		_stored.assign(_slotOfTile.size(), !_writable);
+		_slots.reserve(std::min(_maxTiles, _slotOfTile.size()));
+	}
+
+	TileStore(const TileStore&) = delete;
+	TileStore& operator=(const TileStore&) = delete;
+
+	/// <summary>
+	/// Gets whether all tiles are kept in memory.
+	/// </summary>
+	bool isResident() const
+	{
+		return _resident;
+	}
+
+	/// <summary>
+	/// Sets whether the store is accessed by multiple threads.
+	/// </summary>
+	/// <param name="concurrent">Specifies whether the store is accessed by multiple threads.</param>
+	/// <param name="ioMutex">The mutex guarding the dataset of the band in concurrent mode, <c>nullptr</c> when not shared.</param>
+	void setConcurrent(bool concurrent, std::mutex* ioMutex = nullptr)
+	{
+		_concurrent = concurrent;
+		_ioMutex = ioMutex;
+	}
+
+	/// <summary>
+	/// Retrieves the value at the given position.
+	/// </summary>
+	DataType get(int x, int y)
+	{
+		if (_resident)
+			return at(_slots[_slotOfTile[tileOf(x, y)]], x, y);
+
+		std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+		if (_concurrent)
+			lock.lock();
+		return at(fetch(x, y), x, y);
+	}
+
+	/// <summary>
+	/// Sets the value at the given position.
+	/// </summary>
+	void set(int x, int y, DataType value)
+	{
+		if (_resident)
+		{
+			at(_slots[_slotOfTile[tileOf(x, y)]], x, y) = value;
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+		if (_concurrent)
+			lock.lock();
+		Slot& slot = fetch(x, y);
+		at(slot, x, y) = value;
+		slot.dirty = true;
+	}
+
+	/// <summary>
+	/// Loads all tiles into memory as long as they fit in.
+	/// </summary>
+	/// <param name="band">The band to read the tiles from, e.g. a separate handle on another thread; or <c>nullptr</c> for the paged band.</param>
+	void preload(GDALRasterBand* band = nullptr)
+	{
+		GDALRasterBand* pagedBand = _band;
+		if (band != nullptr)
+			_band = band;
+		try
+		{
+			for (int tile = 0; tile < static_cast<int>(_slotOfTile.size()) &&
+				static_cast<std::size_t>(tile) < _maxTiles; ++tile)
+				fetch((tile % _tileCountX) * _tileSizeX, (tile / _tileCountX) * _tileSizeY);
+		}
+		catch (...)
+		{
+			_band = pagedBand;
+			throw;
+		}
+		_band = pagedBand;
+
+		if (_slots.size() == _slotOfTile.size())
+		{
+			// The resident tiles are written back at once, so they are not tracked for modification
+			_resident = true;
+			if (_writable)
+				for (Slot& slot : _slots)
+					slot.dirty = true;
+		}
+	}
+
+	/// <summary>
+	/// Writes the modified tiles and the never stored areas of a writable band.
+	/// </summary>
+	void flush()
+	{
+		if (!_writable)
+			return;
+
+		for (Slot& slot : _slots)
+			if (slot.dirty)
+				store(slot);
+
+		std::vector<DataType> fill;
+		for (int tile = 0; tile < static_cast<int>(_stored.size()); ++tile)
+			if (!_stored[tile])
+			{
+				if (fill.empty())
+					fill.assign(static_cast<std::size_t>(_tileSizeX) * _tileSizeY, _fillValue);
+				write(tile, fill.data());
+				_stored[tile] = true;
+			}
+	}
+
+private:
+	int tileOf(int x, int y) const
+	{
+		return (y / _tileSizeY) * _tileCountX + x / _tileSizeX;
+	}
+
+	DataType& at(Slot& slot, int x, int y)
+	{
+		return slot.data[static_cast<std::size_t>(y % _tileSizeY) * _tileSizeX + x % _tileSizeX];
+	}
+
+	Slot& fetch(int x, int y)
+	{
+		int tile = tileOf(x, y);
+		if (tile == _lastTile)
+			return *_lastSlot;
+
+		int index = _slotOfTile[tile];
+		if (index < 0)
+		{
+			if (_slots.size() < _maxTiles)
+			{
+				_slots.push_back(Slot{ -1, false, 0, std::vector<DataType>(static_cast<std::size_t>(_tileSizeX) * _tileSizeY) });
+				index = static_cast<int>(_slots.size()) - 1;
+			}
+			else
+			{
+				// Evict the least recently used tile
+				index = static_cast<int>(std::min_element(_slots.begin(), _slots.end(),
+					[](const Slot& a, const Slot& b) { return a.lastUse < b.lastUse; }) - _slots.begin());
+				if (_slots[index].dirty)
+					store(_slots[index]);
+				_slotOfTile[_slots[index].tile] = -1;
+			}
+			load(_slots[index], tile);
+			_slotOfTile[tile] = index;
+		}
+
+		_slots[index].lastUse = ++_useCounter;
+		_lastTile = tile;
+		_lastSlot = &_slots[index];
+		return _slots[index];
+	}
+
+	void load(Slot& slot, int tile)
+	{
+		slot.tile = tile;
+		slot.dirty = false;
+		if (!_stored[tile])
+		{
+			std::fill(slot.data.begin(), slot.data.end(), _fillValue);
+			return;
+		}
+
+		int offsetX = (tile % _tileCountX) * _tileSizeX;
+		int offsetY = (tile / _tileCountX) * _tileSizeY;
+		int sizeX = std::min(_tileSizeX, _sizeX - offsetX);
+		int sizeY = std::min(_tileSizeY, _sizeY - offsetY);
+		std::unique_lock<std::mutex> lock;
+		if (_concurrent && _ioMutex)
+			lock = std::unique_lock<std::mutex>(*_ioMutex);
+		if (_band->RasterIO(GF_Read,
+			offsetX, offsetY,
+			sizeX, sizeY,
+			slot.data.data(), sizeX, sizeY,
+			gdalType<DataType>(),
+			0, static_cast<GSpacing>(_tileSizeX) * sizeof(DataType)) != CE_None)
+			throw std::runtime_error("Source read error occured.");
+		_quantization.dequantize(slot.data.data(), static_cast<std::size_t>(_tileSizeX) * sizeY);
+	}
+
+	void store(Slot& slot)
+	{
+		write(slot.tile, slot.data.data());
+		_stored[slot.tile] = true;
+		slot.dirty = false;
+	}
+
+	void write(int tile, DataType* data)
+	{
+		int offsetX = (tile % _tileCountX) * _tileSizeX;
+		int offsetY = (tile / _tileCountX) * _tileSizeY;
+		int sizeX = std::min(_tileSizeX, _sizeX - offsetX);
+		int sizeY = std::min(_tileSizeY, _sizeY - offsetY);
+		std::unique_lock<std::mutex> lock;
+		if (_concurrent && _ioMutex)
+			lock = std::unique_lock<std::mutex>(*_ioMutex);
+		if (_band->RasterIO(GF_Write,
+			offsetX, offsetY,
+			sizeX, sizeY,
+			data, sizeX, sizeY,
+			gdalType<DataType>(),
+			0, static_cast<GSpacing>(_tileSizeX) * sizeof(DataType)) != CE_None)
+			throw std::runtime_error("Target write error occured.");
+	}
+};
+} // DEM
+} // CloudTools
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Represents a disjoint-set forest over sequential labels.
+/// </summary>
+/// <remarks>
+/// The sets are linked by their smaller root, so the root of a set is always its smallest label.
+/// The lookups halve the paths to the roots, keeping the trees nearly flat.
+/// </remarks>
+class UnionFind
+{
+public:
+	typedef std::uint32_t LabelType;
+
+private:
+	std::vector<LabelType> _parents;
+
+public:
+	/// <summary>
+	/// Initializes a new instance of the class with the given number of singleton sets.
+	/// </summary>
+	/// <param name="count">The number of initial labels (the labels are [0, count)).</param>
+	explicit UnionFind(std::size_t count = 0)
+		: _parents(count)
+	{
+		for (std::size_t label = 0; label < count; ++label)
+			_parents[label] = static_cast<LabelType>(label);
+	}
+
+	/// <summary>
+	/// Gets the number of labels.
+	/// </summary>
+	std::size_t size() const { return _parents.size(); }
+
+	/// <summary>
+	/// Reserves storage for the given number of labels.
+	/// </summary>
+	void reserve(std::size_t count) { _parents.reserve(count); }
+
+	/// <summary>
+	/// Creates a new singleton set.
+	/// </summary>
+	/// <returns>The label of the set.</returns>
+	LabelType add()
+	{
+		LabelType label = static_cast<LabelType>(_parents.size());
+		_parents.push_back(label);
+		return label;
+	}
+
+	/// <summary>
+	/// Retrieves the root of the set containing a label.
+	/// </summary>
+	LabelType find(LabelType label)
+	{
+		while (_parents[label] != label)
+		{
+			_parents[label] = _parents[_parents[label]];
+			label = _parents[label];
+		}
+		return label;
+	}
+
+	/// <summary>
+	/// Merges the sets containing two labels.
+	/// </summary>
+	/// <returns>The root of the merged set.</returns>
+	LabelType unite(LabelType a, LabelType b)
+	{
+		a = find(a);
+		b = find(b);
+		if (a < b)
+			return _parents[b] = a;
+		return _parents[a] = b;
+	}
+};
+} // DEM
+} // CloudTools
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <bitset>
+#include <vector>
+#include <algorithm>
+
+#include <gdal_priv.h>
+
+namespace CloudTools
+{
+namespace DEM
+{
+/// <summary>
+/// Gets the number of words required to store the validity bits of the given number of positions.
+/// </summary>
+/// <param name="size">The number of positions.</param>
+inline int validityWords(int size)
+{
+	return (size + 63) / 64;
+}
+
+/// <summary>
+/// Determines whether the validity bit of the given position is set.
+/// </summary>
+/// <param name="bits">The packed validity bits.</param>
+/// <param name="position">The position.</param>
+inline bool testValidity(const std::uint64_t* bits, int position)
+{
+	return (bits[position >> 6] >> (position & 63)) & 1;
+}
+
+/// <summary>
+/// Counts the valid positions in the given range.
+/// </summary>
+/// <param name="bits">The packed validity bits.</param>
+/// <param name="first">The first position of the range.</param>
+/// <param name="last">The position after the last position of the range.</param>
+inline int countValidity(const std::uint64_t* bits, int first, int last)
+{
+	int count = 0;
+	while (first < last)
+	{
+		int offset = first & 63;
+		int length = std::min(64 - offset, last - first);
+		std::uint64_t word = bits[first >> 6] >> offset;
+		if (length < 64)
+			word &= (std::uint64_t(1) << length) - 1;
+		count += static_cast<int>(std::bitset<64>(word).count());
+		first += length;
+	}
+	return count;
+}
+
+/// <summary>
+/// Replaces the data masked out by the mask band with the nodata value.
+/// </summary>
+/// <remarks>
+/// Afterwards the data itself identifies the invalid positions, so readers not checking the mask see no masked values.
+/// </remarks>
+/// <param name="data">The row of data.</param>
+/// <param name="mask">The row of the mask band, or <c>nullptr</c> when not available.</param>
+/// <param name="size">The length of the row.</param>
+/// <param name="nodataValue">The nodata value.</param>
+template <typename DataType>
+void applyMask(DataType* data, const GByte* mask, std::size_t size, DataType nodataValue)
+{
+	if (mask == nullptr)
+		return;
+	for (std::size_t k = 0; k < size; ++k)
+		data[k] = mask[k] != 0 ? data[k] : nodataValue;
+}
+
+/// <summary>
+/// Packs the validity of a row of data into bits.
+/// </summary>
+/// <remarks>
+/// A position is valid if it differs from the nodata value and its mask value (if given) is non-zero.
+/// The comparisons are branchless, so the loop can be vectorized by the compiler.
+/// </remarks>
+/// <param name="data">The row of data.</param>
+/// <param name="mask">The row of the mask band, or <c>nullptr</c> when not available.</param>
+/// <param name="size">The length of the row.</param>
+/// <param name="nodataValue">The nodata value.</param>
+/// <param name="bits">The target of the validity bits.</param>
+template <typename DataType>
+void packValidity(const DataType* data, const GByte* mask, int size, DataType nodataValue, std::uint64_t* bits)
+{
+	for (int word = 0; word < validityWords(size); ++word)
+	{
+		int first = word * 64;
+		int length = std::min(64, size - first);
+		std::uint64_t value = 0;
+		if (mask != nullptr)
+			for (int k = 0; k < length; ++k)
+				value |= static_cast<std::uint64_t>((data[first + k] != nodataValue) & (mask[first + k] != 0)) << k;
+		else
+			for (int k = 0; k < length; ++k)
+				value |= static_cast<std::uint64_t>(data[first + k] != nodataValue) << k;
+		bits[word] = value;
+	}
+}
+
+/// <summary>
+/// Represents a run of consecutive positions.
+/// </summary>
+struct ValidityRun
+{
+	/// <summary>
+	/// The first position of the run.
+	/// </summary>
+	int begin;
+	/// <summary>
+	/// The position after the last position of the run.
+	/// </summary>
+	int end;
+};
+
+/// <summary>
+/// Collects the runs of positions having valid data within the given horizontal range in any of the rows.
+/// </summary>
+/// <remarks>
+/// The rows are combined word by word, empty words are skipped at once, so the cost is proportional to
+/// the number of words plus the number of occupied words. The runs are sorted and disjoint.
+/// </remarks>
+/// <param name="rows">The packed validity bits of the rows.</param>
+/// <param name="rowCount">The number of rows.</param>
+/// <param name="size">The length of the rows.</param>
+/// <param name="range">The horizontal range to expand the valid positions with.</param>
+/// <param name="offset">The offset to add to the positions.</param>
+/// <param name="limit">The positions of the runs are clipped to <c>[0, limit)</c> after the offset is added.</param>
+/// <param name="runs">The target of the runs.</param>
+inline void collectValidityRuns(const std::uint64_t* const* rows, int rowCount, int size,
+                                int range, int offset, int limit,
+                                std::vector<ValidityRun>& runs)
+{
+	runs.clear();
+	auto append = [&runs, range, offset, limit](int begin, int end)
+	{
+		begin = std::max(0, begin - range + offset);
+		end = std::min(limit, end + range + offset);
+		if (begin >= end)
+			return;
+		if (!runs.empty() && begin <= runs.back().end)
+			runs.back().end = std::max(runs.back().end, end);
+		else
+			runs.push_back(ValidityRun{ begin, end });
+	};
+
+	int begin = -1;
+	for (int word = 0; word < validityWords(size); ++word)
+	{
+		std::uint64_t value = 0;
+		for (int j = 0; j < rowCount; ++j)
+			value |= rows[j][word];
+
+		int first = word * 64;
+		if (value == 0)
+		{
+			if (begin >= 0)
+				append(begin, first);
+			begin = -1;
+		}
+		else if (value == ~std::uint64_t(0))
+		{
+			if (begin < 0)
+				begin = first;
+		}
+		else
+			for (int k = 0; k < 64; ++k)
+			{
+				bool valid = (value >> k) & 1;
+				if (valid && begin < 0)
+					begin = first + k;
+				else if (!valid && begin >= 0)
+				{
+					append(begin, first + k);
+					begin = -1;
+				}
+			}
+	}
+	if (begin >= 0)
+		append(begin, size);
+}
+
+/// <summary>
+/// Retrieves the mask band defining the validity of a raster band beyond its nodata value.
+/// </summary>
+/// <returns>The per-dataset or alpha mask band, <c>nullptr</c> if the validity is defined by the nodata value only.</returns>
+inline GDALRasterBand* validityMaskBand(GDALRasterBand* band)
+{
+	if (band->GetMaskFlags() & (GMF_ALL_VALID | GMF_NODATA))
+		return nullptr;
+	return band->GetMaskBand();
+}
+} // DEM
+} // CloudTools
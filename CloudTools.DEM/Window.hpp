@@ -1,14 +1,24 @@
 #pragma once
 
+#include <cstdint>
+#include <algorithm>
 #include <stdexcept>
 
+#include "ValidityMask.hpp"
+
 namespace CloudTools
 {
 namespace DEM
 {
 /// <summary>
-/// Represents a window to a sub-dataset matrix with continuous representation.
+/// Represents a window to a sub-dataset matrix with row-wise representation.
 /// </summary>
+/// <remarks>
+/// The rows of the sub-dataset are addressed through an array of row pointers,
+/// therefore they are not required to be stored continuously or in order in the memory.
+/// When packed validity bits are given for the rows, the validity queries test the bits
+/// instead of comparing the data to the nodata value.
+/// </remarks>
 template <typename DataType>
 struct Window
 {
@@ -17,7 +27,8 @@ public:
 	int centerY;
 
 private:
-	const DataType* _data;
+	const DataType* const* _rows;
+	const std::uint64_t* const* _validity;
 	const DataType _nodataValue;
 
 	const int _sizeX;
@@ -29,7 +40,7 @@ public:
 	/// <summary>
 	/// Initializes a new instance of the struct.
 	/// </summary>
-	/// <param name="data">The continuous data.</param>
+	/// <param name="rows">The row pointers of the data.</param>
 	/// <param name="nodataValue">The nodata value.</param>
 	/// <param name="sizeX">The width of the matrix.</param>
 	/// <param name="sizeY">The height of the matrix.</param>
@@ -37,11 +48,13 @@ public:
 	/// <param name="offsetY">The ordinate offset of the sub-dataset.</param>
 	/// <param name="centerX">The center abcissa position of inquiry.</param>
 	/// <param name="centerY">The center ordinate position of inquiry.</param>
-	Window(const DataType* data, DataType nodataValue,
+	/// <param name="validity">The row pointers of the packed validity bits, <c>nullptr</c> if not available.</param>
+	Window(const DataType* const* rows, DataType nodataValue,
 	       int sizeX, int sizeY,
 	       int offsetX, int offsetY,
-	       int centerX, int centerY)
-		: _data(data), _nodataValue(nodataValue),
+	       int centerX, int centerY,
+	       const std::uint64_t* const* validity = nullptr)
+		: _rows(rows), _validity(validity), _nodataValue(nodataValue),
 		  _sizeX(sizeX), _sizeY(sizeY),
 		  _offsetX(offsetX), _offsetY(offsetY),
 		  centerX(centerX), centerY(centerY)
@@ -67,7 +80,36 @@ public:
 	{
 		if (!isValid(i, j))
 			return false;
-		return _data[position(i, j)] != _nodataValue;
+		if (_validity != nullptr)
+			return testValidity(_validity[centerY - _offsetY + j], centerX - _offsetX + i);
+		return at(i, j) != _nodataValue;
+	}
+
+	/// <summary>
+	/// Counts the positions containing valid data in the given range around the center.
+	/// </summary>
+	/// <remarks>
+	/// The center is also counted. The result equals to the number of positions for which
+	/// <see cref="hasData(int, int)"/> holds in the <c>(2 * range + 1)^2</c> sized neighborhood.
+	/// </remarks>
+	/// <param name="range">The range of the neighborhood.</param>
+	int dataCount(int range) const
+	{
+		int firstX = std::max(centerX - range, _offsetX) - _offsetX;
+		int lastX = std::min(centerX + range + 1, _offsetX + _sizeX) - _offsetX;
+		int firstY = std::max(centerY - range, _offsetY) - _offsetY;
+		int lastY = std::min(centerY + range + 1, _offsetY + _sizeY) - _offsetY;
+
+		int count = 0;
+		for (int row = firstY; row < lastY; ++row)
+		{
+			if (_validity != nullptr)
+				count += countValidity(_validity[row], firstX, lastX);
+			else
+				for (int column = firstX; column < lastX; ++column)
+					count += _rows[row][column] != _nodataValue;
+		}
+		return count;
 	}
 
 	/// <summary>
@@ -87,7 +129,7 @@ public:
 	{
 		if (!isValid(i, j))
 			return _nodataValue;
-		return _data[position(i, j)];
+		return at(i, j);
 	}
 
 private:
@@ -97,9 +139,9 @@ private:
 			   centerY + j >= _offsetY && centerY + j < _offsetY + _sizeY;
 	}
 
-	int position(int i, int j) const
+	const DataType& at(int i, int j) const
 	{
-		return (centerY - _offsetY + j) * _sizeX + centerX - _offsetX + i;
+		return _rows[centerY - _offsetY + j][centerX - _offsetX + i];
 	}
 };
 } // DEM
@@ -1,3 +1,6 @@
+#include <CloudTools.DEM/RowWindow.hpp>
+#include <CloudTools.DEM/Elementwise.hpp>
+
 #include "EliminateNonTrees.h"
 
 namespace CloudTools
@@ -6,14 +9,11 @@ namespace Vegetation
 {
 void EliminateNonTrees::initialize()
 {
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
 	{
-		const Window<float>& source = sources[0];
-
-		if (!source.hasData() || source.data() < this->threshold)
-			return static_cast<float>(this->nodataValue);
-		else
-			return source.data();
+		const RowWindow<float>& source = sources[0];
+		thresholdSelect(source.data(), source.valid(), source.sizeX(),
+			this->threshold, static_cast<float>(this->nodataValue), target);
 	};
 }
 } // Vegetation
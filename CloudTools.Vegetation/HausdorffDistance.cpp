@@ -24,12 +24,12 @@ void HausdorffDistance::onExecute()
 				continue;
 
 			double cmax = 0;
-			for (const OGRPoint& pointA : clusterMapA.points(indexA))
+			for (const DEM::ClusterPoint& pointA : clusterMapA.points(indexA))
 			{
 				double cmin = std::numeric_limits<double>::max();
-				for (const OGRPoint& pointB : clusterMapB.points(indexB))
+				for (const DEM::ClusterPoint& pointB : clusterMapB.points(indexB))
 				{
-					double dist = pointA.Distance(&pointB);
+					double dist = pointA.distance(pointB);
 					if (dist < cmax)
 					{
 						cmin = 0;
@@ -59,12 +59,12 @@ void HausdorffDistance::onExecute()
 				continue;
 
 			double cmax = 0;
-			for (const OGRPoint& pointB : clusterMapB.points(indexB))
+			for (const DEM::ClusterPoint& pointB : clusterMapB.points(indexB))
 			{
 				double cmin = std::numeric_limits<double>::max();
-				for (const OGRPoint& pointA : clusterMapA.points(indexA))
+				for (const DEM::ClusterPoint& pointA : clusterMapA.points(indexA))
 				{
-					double dist = pointB.Distance(&pointA);
+					double dist = pointB.distance(pointA);
 					if (dist < cmax)
 					{
 						cmin = 0;
@@ -1,3 +1,9 @@
+#include <cmath>
+#include <vector>
+
+#include <CloudTools.DEM/RowWindow.hpp>
+#include <CloudTools.DEM/BoxStatistics.hpp>
+
 #include "InterpolateNoData.h"
 
 namespace CloudTools
@@ -6,33 +12,33 @@ namespace Vegetation
 {
 void InterpolateNoData::initialize()
 {
-	this->computation = [this](int x, int y, const std::vector<CloudTools::DEM::Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<CloudTools::DEM::RowWindow<float>>& sources, float* target)
 	{
-		const CloudTools::DEM::Window<float>& source = sources[0];
-		if (source.hasData())
-			return source.data();
+		const CloudTools::DEM::RowWindow<float>& source = sources[0];
+		const int sizeX = source.sizeX();
 
-		int counter = 0;
-		float data = 0;
+		std::vector<double> data(sizeX);
+		std::vector<int> counter(sizeX);
+		CloudTools::DEM::boxStatistics(source, data.data(), counter.data());
 
-		for (int i = -this->range(); i <= this->range(); i++)
-			for (int j = -this->range(); j <= this->range(); j++)
-				if (source.hasData(i, j))
-				{
-					counter++;
-					data += source.data(i, j);
-				}
+		float threshold = this->threshold;
+		if (threshold > 1.0 || threshold < 0.0)
+			threshold = 0.5;
+		const double minimumCount = (std::pow((this->range() * 2 + 1), 2.0) - 1) * threshold;
 
-		if (this->threshold > 1.0 || this->threshold < 0.0)
-			this->threshold = 0.5;
-
-		if (counter < ((std::pow((this->range() * 2 + 1), 2.0) - 1) * this->threshold))
+		const float* center = source.data();
+		const GByte* centerValid = source.valid();
+		for (int x = 0; x < sizeX; ++x)
 		{
-			return static_cast<float>(this->nodataValue);
+			if (centerValid[x])
+				target[x] = center[x];
+			else if (counter[x] < minimumCount)
+				target[x] = static_cast<float>(this->nodataValue);
+			else
+				target[x] = static_cast<float>(data[x] / counter[x]);
 		}
-
-		return static_cast<float>(data / counter);
 	};
+	this->columnStatistics = true;
 }
 } // Vegetation
 } // CloudTools
@@ -18,11 +18,11 @@ void MorphologyClusterFilter::initialize()
 		int counter;
 		if (this->method == Method::Erosion)
 		{
-			std::vector<OGRPoint> pointSet;
+			std::vector<DEM::ClusterPoint> pointSet;
 			for (GUInt32 index : _clusterMap.clusterIndexes())
 			{
 				pointSet.clear();
-				for (const OGRPoint& p : _clusterMap.points(index))
+				for (const DEM::ClusterPoint& p : _clusterMap.points(index))
 				{
 					counter = 0;
 					for (int i = p.getX() - 1; i <= p.getX() + 1; i++)
@@ -31,7 +31,7 @@ void MorphologyClusterFilter::initialize()
 							OGRPoint point(i, j);
 							if (std::find_if(_clusterMap.points(index).begin(),
 							                 _clusterMap.points(index).end(),
-							                 [&point](const OGRPoint& p)
+							                 [&point](const DEM::ClusterPoint& p)
 							                 {
 								                 return point.getX() == p.getX() &&
 								                        point.getY() == p.getY();
@@ -69,7 +69,7 @@ void MorphologyClusterFilter::initialize()
 							OGRPoint point(i, j);
 							if (std::find_if(_clusterMap.points(index).begin(),
 							                 _clusterMap.points(index).end(),
-							                 [&point](const OGRPoint& p)
+							                 [&point](const DEM::ClusterPoint& p)
 							                 {
 								                 return point.getX() == p.getX() &&
 								                        point.getY() == p.getY();
@@ -1,7 +1,8 @@
 #include <cmath>
 #include <algorithm>
+#include <vector>
 
-#include <CloudTools.DEM/Window.hpp>
+#include <CloudTools.DEM/RowWindow.hpp>
 
 #include "NoiseFilter.h"
 
@@ -18,28 +19,40 @@ NoiseFilter::NoiseFilter(GDALDataset* sourceDataset,
 	: SweepLineTransformation<float>({sourceDataset}, targetPath, range, nullptr, progress)
 {
 	// Noise is the average percentage of difference compared to the surrounding area.
-	this->computation = [this](int x, int y, const std::vector<Window<float>>& sources)
+	this->rowComputation = [this](int y, const std::vector<RowWindow<float>>& sources, float* target)
 	{
-		const Window<float>& source = sources[0];
-		if (!source.hasData()) return static_cast<float>(this->nodataValue);
+		const RowWindow<float>& source = sources[0];
+		const int sizeX = source.sizeX();
+		const float* center = source.data();
+		const GByte* centerValid = source.valid();
 
-		float noise = 0;
-		int counter = -1;
+		std::vector<float> noise(sizeX, 0.f);
+		std::vector<int> counter(sizeX, -1);
 		for (int i = -this->range(); i <= this->range(); ++i)
 			for (int j = -this->range(); j <= this->range(); ++j)
-				if (source.hasData(i, j))
+			{
+				const float* data = source.data(j) + i;
+				const GByte* valid = source.valid(j) + i;
+				for (int x = 0; x < sizeX; ++x)
 				{
-					noise += std::abs(source.data() - source.data(i, j))
-					         / std::min(std::abs(source.data()), std::abs(source.data(i, j)));
-					++counter;
+					float difference = std::abs(center[x] - data[x])
+					                   / std::min(std::abs(center[x]), std::abs(data[x]));
+					noise[x] += valid[x] ? difference : 0.f;
+					counter[x] += valid[x];
 				}
+			}
 
-		if (counter == 0)
-			return source.data();
-		if (noise / counter >= this->threshold)
-			return source.data();
-		else
-			return static_cast<float>(this->nodataValue);
+		const float nodataValue = static_cast<float>(this->nodataValue);
+		const double threshold = this->threshold;
+		for (int x = 0; x < sizeX; ++x)
+		{
+			if (!centerValid[x])
+				target[x] = nodataValue;
+			else if (counter[x] == 0)
+				target[x] = center[x];
+			else
+				target[x] = noise[x] / counter[x] >= threshold ? center[x] : nodataValue;
+		}
 	};
 	this->nodataValue = 0;
 }
@@ -49,7 +49,6 @@ void PostProcess::writeClusterPairsToFile(const std::string& outPath, std::share
 
 	std::srand(42); // Fixed seed, so the random shuffling is reproducible.
 	int commonId;
-	std::vector<OGRPoint> points;
 
 	int numberOfClusters = distance->closest().size();
 	std::vector<int> ids(numberOfClusters);
@@ -61,9 +60,8 @@ void PostProcess::writeClusterPairsToFile(const std::string& outPath, std::share
 		commonId = ids.back();
 		ids.pop_back();
 
-		points = _clustersA.points(elem.first.first);
 		CPLErr ioResult = CE_None;
-		for (const auto& point : points)
+		for (const auto& point : _clustersA.points(elem.first.first))
 		{
 			ioResult = static_cast<CPLErr>(ioResult |
 			                               targetBand->RasterIO(GF_Write,
@@ -75,8 +73,7 @@ void PostProcess::writeClusterPairsToFile(const std::string& outPath, std::share
 			                                                    0, 0));
 		}
 
-		points = _clustersB.points(elem.first.second);
-		for (const auto& point : points)
+		for (const auto& point : _clustersB.points(elem.first.second))
 		{
 			ioResult = static_cast<CPLErr>(ioResult |
 			                               targetBand->RasterIO(GF_Write,
@@ -95,9 +92,8 @@ void PostProcess::writeClusterPairsToFile(const std::string& outPath, std::share
 	commonId = -2;
 	for (auto elem : distance->lonelyA())
 	{
-		points = _clustersA.points(elem);
 		CPLErr ioResult = CE_None;
-		for (const auto& point : points)
+		for (const auto& point : _clustersA.points(elem))
 		{
 			ioResult = static_cast<CPLErr>(ioResult |
 			                               targetBand->RasterIO(GF_Write,
@@ -116,9 +112,8 @@ void PostProcess::writeClusterPairsToFile(const std::string& outPath, std::share
 	commonId = -3;
 	for (auto elem : distance->lonelyB())
 	{
-		points = _clustersB.points(elem);
 		CPLErr ioResult = CE_None;
-		for (const auto& point : points)
+		for (const auto& point : _clustersB.points(elem))
 		{
 			ioResult = static_cast<CPLErr>(ioResult |
 			                               targetBand->RasterIO(GF_Write,
@@ -145,7 +140,7 @@ void PostProcess::writeClusterHeightsToFile(const std::string& outPath, std::sha
 		float clusterHeightA = std::accumulate(
 			_clustersA.points(elem.first.first).begin(),
 			_clustersA.points(elem.first.first).end(), 0.0,
-			[](float sum, const OGRPoint& point)
+			[](float sum, const ClusterPoint& point)
 			{
 				return sum + point.getZ();
 			});
@@ -153,7 +148,7 @@ void PostProcess::writeClusterHeightsToFile(const std::string& outPath, std::sha
 		float clusterHeightB = std::accumulate(
 			_clustersB.points(elem.first.second).begin(),
 			_clustersB.points(elem.first.second).end(), 0.0,
-			[](float sum, const OGRPoint& point)
+			[](float sum, const ClusterPoint& point)
 			{
 				return sum + point.getZ();
 			});
@@ -163,12 +158,12 @@ void PostProcess::writeClusterHeightsToFile(const std::string& outPath, std::sha
 		                      std::max(_clustersA.points(elem.first.first).size(),
 		                               _clustersB.points(elem.first.second).size());
 
-		for (const OGRPoint& point : _clustersA.points(elem.first.first))
+		for (const ClusterPoint& point : _clustersA.points(elem.first.first))
 		{
 			heightMap[std::make_pair(point.getX(), point.getY())] = avgHeightDiff;
 		}
 
-		for (const OGRPoint& point : _clustersB.points(elem.first.second))
+		for (const ClusterPoint& point : _clustersB.points(elem.first.second))
 		{
 			heightMap[std::make_pair(point.getX(), point.getY())] = avgHeightDiff;
 		}
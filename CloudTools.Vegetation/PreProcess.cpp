@@ -3,9 +3,9 @@
 #include <gdal_priv.h>
 #include <ogrsf_frmts.h>
 
-#include <CloudTools.DEM/SweepLineCalculation.hpp>
 #include <CloudTools.DEM/Comparers/Difference.hpp>
 #include <CloudTools.DEM/Algorithms/MatrixTransformation.h>
+#include <CloudTools.DEM/Algorithms/LocalMaxima.hpp>
 
 #include "PreProcess.h"
 #include "EliminateNonTrees.h"
@@ -41,6 +41,7 @@ void PreProcess::onExecute()
 	newResult("CHM");
 	{
 		Difference<float> comparison({_dtmInputPath, _dsmInputPath}, result("CHM").path(), _progress);
+		comparison.quantization = quantization;
 		comparison.execute();
 		result("CHM").dataset = comparison.target();
 		_targetMetadata = comparison.targetMetadata();
@@ -59,6 +60,7 @@ void PreProcess::onExecute()
 	newResult("nosmall");
 	{
 		EliminateNonTrees elimination({result("antialias").dataset}, result("nosmall").path(), _progress);
+		elimination.quantization = quantization;
 		elimination.execute();
 		result("nosmall").dataset = elimination.target();
 	}
@@ -68,6 +70,7 @@ void PreProcess::onExecute()
 	{
 		_progressMessage = "Interpolation (" + _prefix + ")";
 		InterpolateNoData interpolation({result("nosmall").dataset}, result("interpol").path(), _progress);
+		interpolation.quantization = quantization;
 		interpolation.execute();
 		result("interpol").dataset = interpolation.target();
 	}
@@ -134,16 +137,9 @@ void PreProcess::onExecute()
 GDALDataset* PreProcess::blur3x3Middle4(GDALDataset* sourceDataset, const std::string& targetPath)
 {
 	MatrixTransformation filter(sourceDataset, targetPath, 1, _progress);
-	filter.setMatrix(0, 0, 4); // middle
-	filter.setMatrix(0, -1, 2); // sides
-	filter.setMatrix(0, 1, 2);
-	filter.setMatrix(-1, 0, 2);
-	filter.setMatrix(1, 0, 2);
-	filter.setMatrix(-1, -1, 1); // corners
-	filter.setMatrix(1, -1, 1);
-	filter.setMatrix(-1, 1, 1);
-	filter.setMatrix(1, 1, 1);
+	filter.setMatrix({ 1, 2, 1 }, { 1, 2, 1 }); // middle: 4, sides: 2, corners: 1
 
+	filter.quantization = quantization;
 	filter.execute();
 	return filter.target();
 }
@@ -160,6 +156,7 @@ GDALDataset* PreProcess::blur3x3Middle12(GDALDataset* sourceDataset, const std::
 	filter.setMatrix(-1, 1, 1);
 	filter.setMatrix(1, 1, 1);
 
+	filter.quantization = quantization;
 	filter.execute();
 	return filter.target();
 }
@@ -167,52 +164,16 @@ GDALDataset* PreProcess::blur3x3Middle12(GDALDataset* sourceDataset, const std::
 GDALDataset* PreProcess::blur5x5Middle36(GDALDataset* sourceDataset, const std::string& targetPath)
 {
 	MatrixTransformation filter(sourceDataset, targetPath, 2, _progress);
-	for (int i = -2; i <= 2; ++i)
-	{
-		for (int j = -2; j <= -2; ++j)
-		{
-			if (i % 2 == 0 && j % 2 == 0)
-				filter.setMatrix(i, j, 1); // corners
-			else if (i == 0 && j == 0)
-				filter.setMatrix(i, j, 36); // middle
-			else if (std::abs(i) == 1 && std::abs(j) == 2 ||
-			         std::abs(i) == 2 && std::abs(j) == 1)
-				filter.setMatrix(i, j, 4);
-			else if (std::abs(i) == 0 && std::abs(j) == 1 ||
-			         std::abs(i) == 1 && std::abs(j) == 0)
-				filter.setMatrix(i, j, 24);
-			else if (std::abs(i) == 2 && j == 0 ||
-			         std::abs(j) == 2 && i == 0)
-				filter.setMatrix(i, j, 6);
-			else if (std::abs(i) == 1 && std::abs(j) == 1)
-				filter.setMatrix(i, j, 16);
-		}
-	}
+	filter.setMatrix({ 1, 4, 6, 4, 1 }, { 1, 4, 6, 4, 1 }); // middle: 36
 
+	filter.quantization = quantization;
 	filter.execute();
 	return filter.target();
 }
 
 std::vector<OGRPoint> PreProcess::collectSeedPoints(GDALDataset* target)
 {
-	SweepLineCalculation<float> collectSeeds({target}, 7, nullptr, _progress);
-
-	std::vector<OGRPoint> seedPoints;
-	collectSeeds.computation = [&collectSeeds, &seedPoints](int x, int y, const std::vector<Window<float>>& sources)
-	{
-		const Window<float>& source = sources[0];
-		if (!source.hasData())
-			return;
-
-		for (int i = -collectSeeds.range(); i <= collectSeeds.range(); i++)
-			for (int j = -collectSeeds.range(); j <= collectSeeds.range(); j++)
-				if (source.data(i, j) > source.data(0, 0))
-					return;
-		seedPoints.emplace_back(x, y, source.data(0, 0));
-	};
-
-	collectSeeds.execute();
-	return seedPoints;
+	return localMaxima<float>(target, 7, 1, _progress);
 }
 
 void PreProcess::removeDeformedClusters(ClusterMap& clusterMap)
@@ -309,7 +270,6 @@ void PreProcess::writeClusterMapToFile(const std::string& outPath)
 
 	std::srand(42); // Fixed seed, so the random shuffling is reproducible.
 	int commonId;
-	std::vector<OGRPoint> points;
 
 	int numberOfClusters = _targetCluster.clusterIndexes().size();
 	std::vector<int> ids(numberOfClusters);
@@ -321,9 +281,8 @@ void PreProcess::writeClusterMapToFile(const std::string& outPath)
 		commonId = ids.back();
 		ids.pop_back();
 
-		points = _targetCluster.points(index);
 		CPLErr ioResult = CE_None;
-		for (const auto& point : points)
+		for (const auto& point : _targetCluster.points(index))
 		{
 			ioResult = static_cast<CPLErr>(ioResult |
 			                               targetBand->RasterIO(GF_Write,
@@ -4,6 +4,7 @@
 #include <CloudTools.Common/IO/ResultCollection.h>
 #include <CloudTools.DEM/Metadata.h>
 #include <CloudTools.DEM/ClusterMap.h>
+#include <CloudTools.DEM/Quantization.hpp>
 
 namespace CloudTools
 {
@@ -37,6 +38,11 @@ public:
 	/// </summary>
 	bool debug = false;
 
+	/// <summary>
+	/// Quantization of the intermediate height rasters.
+	/// </summary>
+	CloudTools::DEM::Quantization quantization;
+
 protected:
 	/// <summary>
 	/// Internal progress reporter piped to override message.
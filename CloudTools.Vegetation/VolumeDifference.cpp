@@ -34,7 +34,7 @@ std::pair<double, std::map<GUInt32, double>> VolumeDifference::calculateLonelyEp
 	for (const auto& elem : lonely)
 	{
 		double volume = std::accumulate(map.points(elem).begin(), map.points(elem).end(),
-		                                0.0, [](double sum, const OGRPoint& point)
+		                                0.0, [](double sum, const ClusterPoint& point)
 		                                {
 			                                return sum + point.getZ();
 		                                });
@@ -54,7 +54,7 @@ void VolumeDifference::calculateDifference()
 	{
 		clusterVolumeA = std::accumulate(this->clusterMapA.points(elem.first.first).begin(),
 		                                 this->clusterMapA.points(elem.first.first).end(), 0.0,
-		                                 [](double sum, const OGRPoint& point)
+		                                 [](double sum, const ClusterPoint& point)
 		                                    {
 			                                    return sum + point.getZ();
 		                                    });
@@ -63,7 +63,7 @@ void VolumeDifference::calculateDifference()
 
 		clusterVolumeB = std::accumulate(this->clusterMapB.points(elem.first.second).begin(),
 		                                 this->clusterMapB.points(elem.first.second).end(), 0.0,
-		                                 [](double sum, const OGRPoint& point)
+		                                 [](double sum, const ClusterPoint& point)
 		                                    {
 			                                    return sum + point.getZ();
 		                                    });
@@ -28,6 +28,7 @@ int main(int argc, char* argv[])
 	std::string dtmInputPathB;
 	std::string dsmInputPathB;
 	std::string outputDir = fs::current_path().string();
+	double quantizationScale = 0;
 
 	// Read console arguments
 	po::options_description desc("Allowed options");
@@ -39,6 +40,8 @@ int main(int argc, char* argv[])
 		("output-dir,o", po::value<std::string>(&outputDir)->default_value(outputDir), "result directory path")
 		("hausdorff-distance", "use Hausdorff-distance")
 		("parallel,p", "parallel execution for A & B epochs")
+		("quantize", po::value<double>(&quantizationScale),
+		 "store the intermediate height rasters as 16 bit integers with the given step (e.g. 0.01 for centimetres)")
 		("debug,d", "keep intermediate results on disk after progress")
 		("verbose,v", "verbose output")
 		("quiet,q", "suppress progress output")
@@ -92,6 +95,12 @@ int main(int argc, char* argv[])
 		argumentError = true;
 	}
 
+	if (vm.count("quantize") && !(quantizationScale > 0))
+	{
+		std::cerr << "The quantization step must be positive." << std::endl;
+		argumentError = true;
+	}
+
 	if (fs::exists(outputDir) && !fs::is_directory(outputDir))
 	{
 		std::cerr << "The given output path exists but is not a directory." << std::endl;
@@ -141,6 +150,8 @@ int main(int argc, char* argv[])
 
 	preProcessA.debug = vm.count("debug");
 	preProcessB.debug = vm.count("debug");
+	if (vm.count("quantize"))
+		preProcessA.quantization = preProcessB.quantization = Quantization(quantizationScale);
 
 	if (!vm.count("quiet"))
 	{